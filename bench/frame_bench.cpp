@@ -0,0 +1,296 @@
+// Headless frame benchmark: drives `Game::render` through scripted camera
+// paths under SDL's offscreen video driver and software renderer, without the
+// frame cap, and prints frame-time percentiles as one JSON object per line.
+//
+//   GameBench<map size> [frames per scenario] [font path]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include "game.h"
+
+static constexpr int SCREEN_WIDTH = 1024;
+static constexpr int SCREEN_HEIGHT = 800;
+
+struct Samples
+{
+  std::vector<double> total;
+  std::array<std::vector<double>, Game::PHASE_COUNT> phases;
+};
+
+static double percentile(std::vector<double> values, double p)
+{
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+  return values[std::min(index, values.size() - 1)];
+}
+
+static void print_percentiles(const char *name, const std::vector<double> &values)
+{
+  // milliseconds
+  printf("\"%s\":{\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f}", name,
+         percentile(values, 0.50) * 1000.0, percentile(values, 0.95) * 1000.0, percentile(values, 0.99) * 1000.0);
+}
+
+// Runs `frames` frames, `step(frame)` moves the camera/mouse before each one
+static void run_scenario(Game &game, const char *name, int frames, const std::function<void(int)> &step)
+{
+  Samples samples;
+  samples.total.reserve(frames);
+
+  for (int frame = 0; frame < frames; ++frame)
+    {
+      // Input handled by the step is part of the frame
+      Uint64 start = SDL_GetPerformanceCounter();
+      PROFILE_FRAME_BEGIN();
+      game.begin_frame();
+      step(frame);
+
+      game.prev_time = game.curr_time;
+      game.curr_time = SDL_GetPerformanceCounter();
+      game.render();
+      PROFILE_FRAME_END();
+      double total = (SDL_GetPerformanceCounter() - start) / game.frequency;
+
+      samples.total.push_back(total);
+      for (int phase = 0; phase < Game::PHASE_COUNT; ++phase)
+        {
+          samples.phases[phase].push_back(game.phase_time[phase]);
+        }
+    }
+
+  printf("{\"map_size\":%d,\"scenario\":\"%s\",\"frames\":%d,", MAP_SIZE, name, frames);
+  print_percentiles("total", samples.total);
+  printf(",\"phases\":{");
+  for (int phase = 0; phase < Game::PHASE_COUNT; ++phase)
+    {
+      if (phase > 0) printf(",");
+      print_percentiles(Game::PHASE_NAMES[phase], samples.phases[phase]);
+    }
+  printf("}}\n");
+  fflush(stdout);
+}
+
+static void reset_camera(Game &game)
+{
+  game.zoom = 1.0f;
+  game.viewport.x = 0;
+  game.viewport.y = 0;
+  game.prev_camera = {0, 0};
+  game.mouse_position = {SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f};
+}
+
+int main(int argc, char *argv[])
+{
+  const int frames = argc > 1 ? std::max(1, atoi(argv[1])) : 300;
+  const char *font_path = argc > 2 ? argv[2] : "font.ttf";
+
+  SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen,dummy");
+  SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+  if (!SDL_Init(SDL_INIT_VIDEO))
+    {
+      SDL_Log("Couldn't initialise SDL: %s\n", SDL_GetError());
+      return 1;
+    }
+  if (!TTF_Init())
+    {
+      SDL_Log("Couldn't initialise SDL_ttf: %s\n", SDL_GetError());
+      return 1;
+    }
+
+  SDL_Window *window;
+  SDL_Renderer *renderer;
+  if (!SDL_CreateWindowAndRenderer("GameBench", SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_HIDDEN, &window, &renderer))
+    {
+      SDL_Log("Couldn't create window and renderer: %s\n", SDL_GetError());
+      return 1;
+    }
+
+  TTF_Font *font = TTF_OpenFont(font_path, 28);
+  if (!font)
+    {
+      SDL_Log("Could not load %s! SDL_ttf Error: %s\n", font_path, SDL_GetError());
+      return 1;
+    }
+
+  Game *game = new Game(window, renderer, font);
+  if (!game->create_world()) return 1;
+
+  // Generation has its own cost, keep it out of the frame numbers
+  Uint64 start = SDL_GetPerformanceCounter();
+  game->initialize_map();
+  game->generate_all();
+  double generation = (SDL_GetPerformanceCounter() - start) / game->frequency;
+  // Textures too, the scenarios should draw the same thing every run
+  game->jobs.wait_idle();
+  while (game->assets.loading()) game->assets.upload(renderer, 1.0);
+
+  printf("{\"map_size\":%d,\"scenario\":\"generate\",\"workers\":%d,\"seconds\":%.6f}\n",
+         MAP_SIZE, game->jobs.worker_count(), generation);
+
+  // Same graph and seed again: every chunk's noise comes from the cache
+  start = SDL_GetPerformanceCounter();
+  game->initialize_map();
+  game->generate_all();
+  printf("{\"map_size\":%d,\"scenario\":\"regenerate\",\"cache_hits\":%d,\"cache_misses\":%d,\"seconds\":%.6f}\n",
+         MAP_SIZE, game->generator.cache_hits(), game->generator.cache_misses(),
+         (SDL_GetPerformanceCounter() - start) / game->frequency);
+
+  const float extent = static_cast<float>(MAP_SIZE * TILE_SIZE);
+
+  reset_camera(*game);
+  run_scenario(*game, "idle", frames, [](int) {});
+
+  // Middle-drag panning diagonally across the whole map
+  reset_camera(*game);
+  run_scenario(*game, "pan", frames, [&](int)
+    {
+      const float step = (extent - SCREEN_WIDTH) / frames;
+      SDL_MouseMotionEvent motion = {};
+      game->snap_offset = {0, 0};
+      motion.x = -step;
+      motion.y = -step * SCREEN_HEIGHT / SCREEN_WIDTH;
+      game->handle_snapping(motion);
+    });
+
+  // Zoom all the way out and back in around the screen center
+  reset_camera(*game);
+  run_scenario(*game, "zoom", frames, [&](int frame)
+    {
+      const float wheel = (frame / 20) % 2 == 0 ? -1.0f : 1.0f;
+      game->handle_mouse_wheel(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, wheel);
+    });
+
+  // Mouse sweeping the screen row by row, changes the hovered tile every frame
+  reset_camera(*game);
+  run_scenario(*game, "hover", frames, [&](int frame)
+    {
+      const int per_row = SCREEN_WIDTH / TILE_SIZE;
+      game->mouse_position.x = static_cast<float>((frame % per_row) * TILE_SIZE + TILE_SIZE / 2);
+      game->mouse_position.y = static_cast<float>(((frame / per_row) * TILE_SIZE) % SCREEN_HEIGHT + TILE_SIZE / 2);
+    });
+
+  // Selection toggles under a moving mouse, every frame dirties a chunk
+  reset_camera(*game);
+  run_scenario(*game, "edit", frames, [&](int frame)
+    {
+      game->mouse_position.x = static_cast<float>((frame * 37) % SCREEN_WIDTH);
+      game->mouse_position.y = static_cast<float>((frame * 53) % SCREEN_HEIGHT);
+      int index = game->tile_at(game->screen_to_world(game->mouse_position));
+      if (index >= 0) game->toggle_selected(index);
+    });
+
+  // Quarter-map boxes and lassos, one per frame, alternately added and removed
+  reset_camera(*game);
+  std::vector<SDL_FPoint> lasso;
+  run_scenario(*game, "select", frames, [&](int frame)
+    {
+      const int half = MAP_SIZE / 2;
+      const int offset = frame % half;
+      game->select_shape.clear();
+      if ((frame / 2) % 2 == 0)
+        {
+          game->select_shape.fill_rect({offset, offset, half, half});
+        }
+      else
+        {
+          lasso.clear();
+          for (int i = 0; i < 64; ++i)
+            {
+              const float angle = i * 2.0f * SDL_PI_F / 64;
+              const float radius = half * (i % 2 == 0 ? 0.5f : 0.35f);
+              lasso.push_back({offset + half * 0.5f + radius * SDL_cosf(angle), offset + half * 0.5f + radius * SDL_sinf(angle)});
+            }
+          game->select_shape.fill_polygon(lasso, game->scratch_arena);
+        }
+      game->select(game->select_shape, frame % 2 == 0 ? SelectOp::Union : SelectOp::Subtract);
+    });
+
+  // The whole map in view through the LOD texture, with an edit every frame
+  reset_camera(*game);
+  game->zoom = MIN_ZOOM;
+  run_scenario(*game, "far", frames, [&](int frame)
+    {
+      const int index = (frame * 7919) % TILE_COUNT;
+      game->set_kind(index, game->tiles.kinds[index] == Grass ? Dirt : Grass);
+    });
+
+  // A flood fill over a block of 5/8 of the map (100k tiles at 512), then
+  // undone and redone in turn, one stroke per frame
+  reset_camera(*game);
+  const int block = MAP_SIZE * 5 / 8;
+  TileBits stroke;
+  stroke.fill_rect({0, 0, block, block});
+  game->paint(stroke, Lava);
+  run_scenario(*game, "brush", frames, [&](int frame)
+    {
+      if (frame == 0)
+        {
+          std::vector<SDL_Rect> squares;
+          game->terrain.flood_fill((block / 2) * MAP_SIZE + block / 2, squares);
+          stroke.clear();
+          for (const SDL_Rect &square : squares) stroke.fill_rect(square);
+          game->paint(stroke, Water);
+        }
+      else if (frame % 2 == 1)
+        {
+          game->undo_edit();
+        }
+      else
+        {
+          game->redo_edit();
+        }
+    });
+
+  // 50k units walking around, with the fixed update in every frame
+  reset_camera(*game);
+  game->spawn_units(50000, 1);
+  run_scenario(*game, "units", frames, [&](int)
+    {
+      game->update(SIM_TIMESTEP);
+    });
+  game->units.clear();
+
+  // Fog drawn over the view, its viewers walking and recomputed in every update
+  reset_camera(*game);
+  game->spawn_units(FOG_VIEWERS, 2);
+  game->show_fog = true;
+  run_scenario(*game, "fog", frames, [&](int)
+    {
+      game->update(SIM_TIMESTEP);
+    });
+  game->show_fog = false;
+  game->units.clear();
+
+  // Full-map terrain steps: every chunk stepped, not only the changing ones
+  start = SDL_GetPerformanceCounter();
+  for (int step = 0; step < frames; ++step)
+    {
+      game->sim.activate_all();
+      for (int index : game->sim.step(game->jobs))
+        {
+          game->finish_tile(index, game->sim.previous(index));
+        }
+    }
+  printf("{\"map_size\":%d,\"scenario\":\"terrain\",\"steps\":%d,\"seconds_per_step\":%.6f}\n",
+         MAP_SIZE, frames, (SDL_GetPerformanceCounter() - start) / game->frequency / frames);
+
+  game->jobs.stop();
+  game->destroy_text(&game->fps_text);
+  game->text_engine.destroy();
+  TTF_CloseFont(font);
+  SDL_DestroyRenderer(renderer);
+  SDL_DestroyWindow(window);
+  TTF_Quit();
+  SDL_Quit();
+  return 0;
+}
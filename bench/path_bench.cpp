@@ -0,0 +1,120 @@
+// Pathfinding benchmark: plain A* against the hierarchical mode on a generated
+// map, batched requests on the worker pool and the cost of repairing the
+// cluster graph after edits. Prints one JSON object per measurement.
+//
+//   PathBench [requests] [seed]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "generator.h"
+#include "jobs.h"
+#include "path.h"
+
+static double seconds_since(Uint64 start)
+{
+  return (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char *argv[])
+{
+  const int count = argc > 1 ? std::max(1, atoi(argv[1])) : 500;
+  const int seed = argc > 2 ? atoi(argv[2]) : 12237861;
+
+  // No workers yet: every chunk is generated inline by `request`
+  JobSystem jobs;
+  TileMap tiles;
+  TerrainGenerator generator;
+  generator.reset(jobs, tiles, seed);
+  for (int index = 0; index < CHUNK_COUNT * CHUNK_COUNT; ++index)
+    {
+      generator.request(jobs, index);
+    }
+  generator.collect_finished(tiles);
+
+  PathFinder paths(tiles);
+  std::vector<int> path;
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  paths.find_path(0, 0, path);
+  printf("{\"map_size\":%d,\"measure\":\"build\",\"clusters\":%d,\"seconds\":%.6f}\n",
+         MAP_SIZE, paths.rebuilt_count(), seconds_since(start));
+
+  // Endpoints on passable tiles only, the same for every mode
+  std::vector<int> open;
+  for (int index = 0; index < TILE_COUNT; ++index)
+    {
+      if (TERRAIN_COST[tiles.kinds[index]]) open.push_back(index);
+    }
+  if (open.empty()) return 1;
+
+  std::mt19937 rng(seed);
+  std::vector<PathRequest> requests(count);
+  for (auto &request : requests)
+    {
+      request = {open[rng() % open.size()], open[rng() % open.size()]};
+    }
+
+  std::vector<int> grid_costs(count), hierarchical_costs(count);
+  double seconds[2];
+  for (int mode = 0; mode < 2; ++mode)
+    {
+      auto &costs = mode == 0 ? grid_costs : hierarchical_costs;
+      start = SDL_GetPerformanceCounter();
+      for (int i = 0; i < count; ++i)
+        {
+          costs[i] = paths.find_path(requests[i].from, requests[i].to, path, mode == 0 ? PathMode::Grid : PathMode::Hierarchical);
+        }
+      seconds[mode] = seconds_since(start);
+    }
+
+  int found = 0, mismatched = 0;
+  double ratio = 0;
+  for (int i = 0; i < count; ++i)
+    {
+      if ((grid_costs[i] < 0) != (hierarchical_costs[i] < 0)) ++mismatched;
+      if (grid_costs[i] <= 0 || hierarchical_costs[i] < 0) continue;
+      ++found;
+      ratio += (double)hierarchical_costs[i] / grid_costs[i];
+    }
+
+  printf("{\"map_size\":%d,\"measure\":\"single\",\"requests\":%d,\"found\":%d,\"grid_us\":%.3f,\"hierarchical_us\":%.3f,"
+         "\"speedup\":%.1f,\"cost_ratio\":%.4f,\"reachability_mismatches\":%d}\n",
+         MAP_SIZE, count, found, seconds[0] * 1e6 / count, seconds[1] * 1e6 / count,
+         seconds[1] > 0 ? seconds[0] / seconds[1] : 0.0, found ? ratio / found : 0.0, mismatched);
+
+  // The same requests as one batch, inline and then on the pool
+  std::vector<PathResult> results;
+  const int workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+  for (int pass = 0; pass < 2; ++pass)
+    {
+      if (pass == 1) jobs.start(workers);
+      start = SDL_GetPerformanceCounter();
+      paths.find_paths(jobs, requests, results);
+      const double elapsed = seconds_since(start);
+      printf("{\"map_size\":%d,\"measure\":\"batch\",\"workers\":%d,\"requests\":%d,\"ms\":%.3f,\"requests_per_second\":%.0f}\n",
+             MAP_SIZE, jobs.worker_count(), count, elapsed * 1000.0, elapsed > 0 ? count / elapsed : 0.0);
+    }
+  jobs.stop();
+
+  // Flip a tile and query across the map: only the touched clusters are rebuilt
+  const int rebuilt = paths.rebuilt_count();
+  start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < count; ++i)
+    {
+      const int index = open[rng() % open.size()];
+      tiles.kinds[index] = tiles.kinds[index] == Grass ? Dirt : Grass;
+      paths.mark_dirty(index);
+      paths.find_path(requests[i].from, requests[i].to, path);
+    }
+  printf("{\"map_size\":%d,\"measure\":\"repair\",\"edits\":%d,\"clusters_rebuilt\":%d,\"us_per_edit_and_query\":%.3f}\n",
+         MAP_SIZE, count, paths.rebuilt_count() - rebuilt, seconds_since(start) * 1e6 / count);
+
+  return 0;
+}
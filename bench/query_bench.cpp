@@ -0,0 +1,193 @@
+// Region query benchmark: times TerrainQuery against plain scans of the kind
+// plane on a generated map and prints one JSON object per query, with the
+// mean time per call in microseconds.
+//
+//   QueryBench [iterations] [seed]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "generator.h"
+#include "jobs.h"
+#include "query.h"
+
+static double seconds_since(Uint64 start)
+{
+  return (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+// Runs `query(i)` for every i, returns a checksum so nothing gets optimized out
+static long long time_calls(int iterations, double &seconds, const std::function<long long(int)> &query)
+{
+  long long checksum = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < iterations; ++i)
+    {
+      checksum += query(i);
+    }
+  seconds = seconds_since(start);
+  return checksum;
+}
+
+static void report(const char *name, int iterations, double indexed, double naive, bool match)
+{
+  printf("{\"map_size\":%d,\"query\":\"%s\",\"iterations\":%d,\"indexed_us\":%.3f,\"naive_us\":%.3f,\"speedup\":%.1f,\"match\":%s}\n",
+         MAP_SIZE, name, iterations, indexed * 1e6 / iterations, naive * 1e6 / iterations,
+         indexed > 0 ? naive / indexed : 0.0, match ? "true" : "false");
+  fflush(stdout);
+}
+
+static int naive_count(const TileMap &tiles, TerrainKind kind, const SDL_Rect &area)
+{
+  int count = 0;
+  for (int y = area.y; y < area.y + area.h; ++y)
+    {
+      for (int x = area.x; x < area.x + area.w; ++x)
+        {
+          count += tiles.kinds[y * MAP_SIZE + x] == kind;
+        }
+    }
+  return count;
+}
+
+static bool naive_uniform(const TileMap &tiles, const SDL_Rect &area)
+{
+  const TerrainKind kind = tiles.kinds[area.y * MAP_SIZE + area.x];
+  for (int y = area.y; y < area.y + area.h; ++y)
+    {
+      for (int x = area.x; x < area.x + area.w; ++x)
+        {
+          if (tiles.kinds[y * MAP_SIZE + x] != kind) return false;
+        }
+    }
+  return true;
+}
+
+static int naive_flood_fill(const TileMap &tiles, int index, std::vector<uint8_t> &visited, std::vector<int> &stack)
+{
+  std::fill(visited.begin(), visited.end(), 0);
+  const TerrainKind kind = tiles.kinds[index];
+  int count = 0;
+
+  stack.clear();
+  stack.push_back(index);
+  visited[index] = 1;
+  while (!stack.empty())
+    {
+      const int tile = stack.back();
+      stack.pop_back();
+      ++count;
+
+      const auto neighbors = Tile{tile}.get_neighbors();
+      // top, right, bottom and left: 4-connected only
+      for (int side = 0; side < 8; side += 2)
+        {
+          const int neighbor = neighbors[side];
+          if (neighbor < 0 || visited[neighbor] || tiles.kinds[neighbor] != kind) continue;
+          visited[neighbor] = 1;
+          stack.push_back(neighbor);
+        }
+    }
+  return count;
+}
+
+int main(int argc, char *argv[])
+{
+  const int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 2000;
+  const int seed = argc > 2 ? atoi(argv[2]) : 12237861;
+
+  // No workers: every chunk is generated inline by `request`
+  JobSystem jobs;
+  TileMap tiles;
+  TerrainGenerator generator;
+  generator.reset(jobs, tiles, seed);
+  for (int index = 0; index < CHUNK_COUNT * CHUNK_COUNT; ++index)
+    {
+      generator.request(jobs, index);
+    }
+  generator.collect_finished(tiles);
+
+  TerrainQuery terrain(tiles);
+  Uint64 start = SDL_GetPerformanceCounter();
+  terrain.invalidate();
+  terrain.count(Water, {0, 0, 1, 1});
+  printf("{\"map_size\":%d,\"query\":\"build\",\"seconds\":%.6f}\n", MAP_SIZE, seconds_since(start));
+
+  // The same random rectangles and tiles for every query
+  std::mt19937 rng(seed);
+  std::vector<SDL_Rect> areas(iterations);
+  std::vector<int> seeds(iterations);
+  for (int i = 0; i < iterations; ++i)
+    {
+      const int w = 1 + rng() % (MAP_SIZE / 2), h = 1 + rng() % (MAP_SIZE / 2);
+      areas[i] = {static_cast<int>(rng() % (MAP_SIZE - w + 1)), static_cast<int>(rng() % (MAP_SIZE - h + 1)), w, h};
+      seeds[i] = rng() % TILE_COUNT;
+    }
+
+  double indexed, naive;
+  long long a, b;
+
+  a = time_calls(iterations, indexed, [&](int i) { return terrain.count(Water, areas[i]); });
+  b = time_calls(iterations, naive, [&](int i) { return naive_count(tiles, Water, areas[i]); });
+  report("count", iterations, indexed, naive, a == b);
+
+  a = time_calls(iterations, indexed, [&](int i) { return terrain.is_uniform(areas[i]); });
+  b = time_calls(iterations, naive, [&](int i) { return naive_uniform(tiles, areas[i]); });
+  report("is_uniform", iterations, indexed, naive, a == b);
+
+  // Small areas are where the answer is often yes and scans go to the end
+  std::vector<SDL_Rect> small(areas);
+  for (auto &area : small)
+    {
+      area.w = std::min(area.w, 8);
+      area.h = std::min(area.h, 8);
+    }
+  a = time_calls(iterations, indexed, [&](int i) { return terrain.is_uniform(small[i]); });
+  b = time_calls(iterations, naive, [&](int i) { return naive_uniform(tiles, small[i]); });
+  report("is_uniform_small", iterations, indexed, naive, a == b);
+
+  std::vector<SDL_Rect> squares;
+  std::vector<uint8_t> visited(TILE_COUNT);
+  std::vector<int> stack;
+  a = time_calls(iterations, indexed, [&](int i)
+    {
+      squares.clear();
+      return terrain.flood_fill(seeds[i], squares);
+    });
+  b = time_calls(iterations, naive, [&](int i) { return naive_flood_fill(tiles, seeds[i], visited, stack); });
+  report("flood_fill", iterations, indexed, naive, a == b);
+
+  // The terrain simulation's pattern: a few hundred single tile changes
+  // between queries. `set` keeps the trees current, the naive side rebuilds
+  // them on the next query like a bulk change would.
+  constexpr int CHANGES_PER_QUERY = 256;
+  const int rounds = std::max(1, iterations / 16);
+  auto edit_round = [&](int round, bool incremental)
+    {
+      for (int i = 0; i < CHANGES_PER_QUERY; ++i)
+        {
+          const int index = seeds[(round * CHANGES_PER_QUERY + i) % iterations];
+          const TerrainKind previous = tiles.kinds[index];
+          const TerrainKind kind = previous == Water ? Grass : Water;
+          tiles.kinds[index] = kind;
+          if (incremental) terrain.set(index, previous, kind);
+        }
+      if (!incremental) terrain.invalidate();
+      return static_cast<long long>(terrain.count(Water, areas[round % iterations]));
+    };
+  // Both sides start from the same map, so they answer the same
+  const std::vector<TerrainKind> before = tiles.kinds;
+  a = time_calls(rounds, indexed, [&](int i) { return edit_round(i, true); });
+  tiles.kinds = before;
+  terrain.invalidate();
+  b = time_calls(rounds, naive, [&](int i) { return edit_round(i, false); });
+  report("set_then_count", rounds, indexed, naive, a == b);
+
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Headless replay: plays an input journal back under SDL's offscreen video
+// driver and software renderer, one fixed update and one frame per tick as
+// fast as possible, and prints frame-time percentiles as one JSON object.
+//
+//   GameReplay <journal> [font path]
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include "game.h"
+
+static constexpr int SCREEN_WIDTH = 1024;
+static constexpr int SCREEN_HEIGHT = 800;
+
+static double percentile(std::vector<double> values, double p)
+{
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+  return values[std::min(index, values.size() - 1)];
+}
+
+static void print_percentiles(const char *name, const std::vector<double> &values)
+{
+  // milliseconds
+  printf("\"%s\":{\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f,\"max\":%.4f}", name,
+         percentile(values, 0.50) * 1000.0, percentile(values, 0.95) * 1000.0, percentile(values, 0.99) * 1000.0,
+         percentile(values, 1.0) * 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      SDL_Log("usage: %s <journal> [font path]", argv[0]);
+      return 1;
+    }
+  const char *font_path = argc > 2 ? argv[2] : "font.ttf";
+
+  SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen,dummy");
+  SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+  if (!SDL_Init(SDL_INIT_VIDEO))
+    {
+      SDL_Log("Couldn't initialise SDL: %s\n", SDL_GetError());
+      return 1;
+    }
+  if (!TTF_Init())
+    {
+      SDL_Log("Couldn't initialise SDL_ttf: %s\n", SDL_GetError());
+      return 1;
+    }
+
+  SDL_Window *window;
+  SDL_Renderer *renderer;
+  if (!SDL_CreateWindowAndRenderer("GameReplay", SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_HIDDEN, &window, &renderer))
+    {
+      SDL_Log("Couldn't create window and renderer: %s\n", SDL_GetError());
+      return 1;
+    }
+
+  TTF_Font *font = TTF_OpenFont(font_path, 28);
+  if (!font)
+    {
+      SDL_Log("Could not load %s! SDL_ttf Error: %s\n", font_path, SDL_GetError());
+      return 1;
+    }
+
+  Game *game = new Game(window, renderer, font);
+  if (!game->create_world()) return 1;
+  if (!game->start_replay(argv[1])) return 1;
+
+  // The map was generated by `start_replay`, like when the session was
+  // recorded. Textures too, so every run draws the same thing.
+  game->jobs.wait_idle();
+  while (game->assets.loading()) game->assets.upload(renderer, 1.0);
+
+  std::vector<double> total;
+  std::array<std::vector<double>, Game::PHASE_COUNT> phases;
+  bool running = true;
+
+  while (running)
+    {
+      Uint64 start = SDL_GetPerformanceCounter();
+      PROFILE_FRAME_BEGIN();
+      game->begin_frame();
+      running = game->replay_tick();
+
+      game->prev_time = game->curr_time;
+      game->curr_time = SDL_GetPerformanceCounter();
+      game->render();
+      PROFILE_FRAME_END();
+
+      total.push_back((SDL_GetPerformanceCounter() - start) / game->frequency);
+      for (int phase = 0; phase < Game::PHASE_COUNT; ++phase)
+        {
+          phases[phase].push_back(game->phase_time[phase]);
+        }
+    }
+
+  printf("{\"map_size\":%d,\"journal\":\"%s\",\"ticks\":%llu,", MAP_SIZE, argv[1], (unsigned long long)game->sim_ticks);
+  print_percentiles("total", total);
+  printf(",\"phases\":{");
+  for (int phase = 0; phase < Game::PHASE_COUNT; ++phase)
+    {
+      if (phase > 0) printf(",");
+      print_percentiles(Game::PHASE_NAMES[phase], phases[phase]);
+    }
+  printf("}}\n");
+
+  game->jobs.stop();
+  game->destroy_text(&game->fps_text);
+  game->text_engine.destroy();
+  TTF_CloseFont(font);
+  SDL_DestroyRenderer(renderer);
+  SDL_DestroyWindow(window);
+  TTF_Quit();
+  SDL_Quit();
+  return 0;
+}
@@ -1,25 +1,97 @@
 #include "asset.h"
 
-bool Asset::load_texture(SDL_Renderer* renderer, const std::string& id, const std::string& path) {
-  SDL_Texture* texture = IMG_LoadTexture(renderer, path.c_str());
-  
-  if (!texture) {
-    SDL_Log("Failed to create texture for '%s': %s", path.c_str(), SDL_GetError());
-    return false;
+TextureHandle Asset::load_texture(JobSystem& jobs, const char* path) {
+  if (count_ >= MAX_TEXTURES) {
+    SDL_Log("Too many textures, can't load '%s'", path);
+    return {};
   }
-  
-  textures_[id] = texture;
-  return true;
+  if (SDL_strlen(path) >= sizeof entries_[0].path) {
+    SDL_Log("Texture path too long: '%s'", path);
+    return {};
+  }
+
+  const uint16_t index = static_cast<uint16_t>(count_++);
+  Entry& entry = entries_[index];
+  SDL_strlcpy(entry.path, path, sizeof entry.path);
+  entry.state = AssetState::Decoding;
+  ++loading_;
+
+  // The entry's path stays put, the array never moves
+  jobs.submit([this, index]() {
+    Entry& entry = entries_[index];
+    SDL_Surface* surface = IMG_Load(entry.path);
+    // Published to the main thread by the mutex, with the surface
+    if (!surface) SDL_strlcpy(entry.error, SDL_GetError(), sizeof entry.error);
+
+    std::lock_guard lock(decoded_mutex_);
+    decoded_.push_back({index, surface});
+  });
+
+  return {index};
 }
 
-SDL_Texture* Asset::get_texture(const std::string& id) const {
-  auto it = textures_.find(id);
-  return (it != textures_.end()) ? it->second : nullptr;
+int Asset::upload(SDL_Renderer* renderer, double budget_seconds) {
+  {
+    std::lock_guard lock(decoded_mutex_);
+    for (auto& decoded : decoded_) {
+      entries_[decoded.index].state = AssetState::Uploading;
+    }
+    uploading_.insert(uploading_.end(), decoded_.begin(), decoded_.end());
+    decoded_.clear();
+  }
+  if (uploading_.empty()) return 0;
+
+  const Uint64 start = SDL_GetPerformanceCounter();
+  const Uint64 budget = static_cast<Uint64>(budget_seconds * SDL_GetPerformanceFrequency());
+  int ready = 0;
+  size_t done = 0;
+
+  // At least one upload per call, so a tight budget still makes progress
+  for (; done < uploading_.size(); ++done) {
+    if (done > 0 && SDL_GetPerformanceCounter() - start > budget) break;
+
+    auto [index, surface] = uploading_[done];
+    Entry& entry = entries_[index];
+    --loading_;
+
+    if (!surface) {
+      SDL_Log("Failed to load '%s': %s", entry.path, entry.error);
+      entry.state = AssetState::Failed;
+      continue;
+    }
+
+    entry.texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_DestroySurface(surface);
+
+    if (!entry.texture) {
+      SDL_Log("Failed to create texture for '%s': %s", entry.path, SDL_GetError());
+      entry.state = AssetState::Failed;
+      continue;
+    }
+
+    entry.state = AssetState::Ready;
+    ++ready;
+  }
+
+  uploading_.erase(uploading_.begin(), uploading_.begin() + done);
+  return ready;
 }
 
 void Asset::unload_all() {
-  for (auto& [_, tex] : textures_) {
-    SDL_DestroyTexture(tex);
+  {
+    std::lock_guard lock(decoded_mutex_);
+    uploading_.insert(uploading_.end(), decoded_.begin(), decoded_.end());
+    decoded_.clear();
+  }
+  for (auto& pending : uploading_) {
+    SDL_DestroySurface(pending.surface);
+  }
+  uploading_.clear();
+
+  for (int i = 0; i < count_; ++i) {
+    SDL_DestroyTexture(entries_[i].texture);
+    entries_[i] = {};
   }
-  textures_.clear();
+  count_ = 0;
+  loading_ = 0;
 }
@@ -1,17 +1,67 @@
 #pragma once
 
-#include <unordered_map>
-#include <string>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
 
+#include "jobs.h"
+
+enum class AssetState : uint8_t
+{
+  Unloaded,
+  Decoding,  // a worker is decoding the image
+  Uploading, // decoded, waiting for its texture upload
+  Ready,
+  Failed,
+};
+
+// Small typed handle to a texture, resolved once when the load is requested
+struct TextureHandle
+{
+  static constexpr uint16_t INVALID = 0xffff;
+  uint16_t index = INVALID;
+
+  bool valid() const { return index != INVALID; }
+};
+
+// Images are decoded to surfaces on the worker pool and turned into textures
+// on the main thread by `upload`, within a time budget per frame. Lookups are
+// plain array indexing, a texture is nullptr until it is Ready.
 class Asset {
  public:
-  bool load_texture(SDL_Renderer* renderer, const std::string& id, const std::string& path);
-  SDL_Texture* get_texture(const std::string& id) const;
+  static constexpr int MAX_TEXTURES = 64;
+
+  TextureHandle load_texture(JobSystem& jobs, const char* path);
+  // Returns how many textures became ready
+  int upload(SDL_Renderer* renderer, double budget_seconds);
+
+  SDL_Texture* get(TextureHandle handle) const { return handle.valid() ? entries_[handle.index].texture : nullptr; }
+  AssetState state(TextureHandle handle) const { return handle.valid() ? entries_[handle.index].state : AssetState::Failed; }
+  bool loading() const { return loading_ > 0; }
+
   void unload_all();
 
  private:
-  std::unordered_map<std::string, SDL_Texture*> textures_;
+  struct Entry {
+    SDL_Texture* texture = nullptr;
+    AssetState state = AssetState::Unloaded;
+    char path[256] = {0};
+    char error[128] = {0}; // why decoding failed, SDL errors are per thread
+  };
+
+  struct Decoded {
+    uint16_t index;
+    SDL_Surface* surface; // nullptr when decoding failed
+  };
+
+  std::array<Entry, MAX_TEXTURES> entries_;
+  int count_ = 0;
+  int loading_ = 0;
+
+  std::mutex decoded_mutex_;
+  std::vector<Decoded> decoded_, uploading_;
 };
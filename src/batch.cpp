@@ -0,0 +1,67 @@
+#include "batch.h"
+
+static SDL_FColor to_fcolor(SDL_Color color)
+{
+  return {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+}
+
+TileBatch::Group &TileBatch::group_for(SDL_Texture *texture)
+{
+  for (auto &group : groups)
+    {
+      if (group.texture == texture) return group;
+    }
+
+  // @note: groups are never erased, only emptied, so this only happens the
+  // first time a texture is seen
+  auto &group = groups.emplace_back();
+  group.texture = texture;
+  if (texture)
+    {
+      SDL_GetTextureSize(texture, &group.width, &group.height);
+    }
+  return group;
+}
+
+void TileBatch::push_quad(Group &group, const SDL_FRect &dst, SDL_FColor color, const SDL_FRect &uv)
+{
+  const int base = static_cast<int>(group.vertices.size());
+
+  group.vertices.push_back({{dst.x, dst.y}, color, {uv.x, uv.y}});
+  group.vertices.push_back({{dst.x + dst.w, dst.y}, color, {uv.x + uv.w, uv.y}});
+  group.vertices.push_back({{dst.x + dst.w, dst.y + dst.h}, color, {uv.x + uv.w, uv.y + uv.h}});
+  group.vertices.push_back({{dst.x, dst.y + dst.h}, color, {uv.x, uv.y + uv.h}});
+
+  const int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+  group.indices.insert(group.indices.end(), quad, quad + 6);
+}
+
+void TileBatch::push_rect(const SDL_FRect &dst, SDL_Color color)
+{
+  push_quad(groups[0], dst, to_fcolor(color), {0, 0, 0, 0});
+}
+
+void TileBatch::push_sprite(SDL_Texture *texture, const SDL_FRect &src, const SDL_FRect &dst, SDL_Color tint)
+{
+  auto &group = group_for(texture);
+  const SDL_FRect uv = {src.x / group.width, src.y / group.height, src.w / group.width, src.h / group.height};
+  push_quad(group, dst, to_fcolor(tint), uv);
+}
+
+void TileBatch::flush(SDL_Renderer *renderer, RenderStats &stats)
+{
+  for (auto &group : groups)
+    {
+      if (group.indices.empty()) continue;
+
+      SDL_RenderGeometry(renderer, group.texture,
+                         group.vertices.data(), static_cast<int>(group.vertices.size()),
+                         group.indices.data(), static_cast<int>(group.indices.size()));
+
+      stats.draw_calls += 1;
+      stats.quads += static_cast<int>(group.vertices.size() / 4);
+
+      group.vertices.clear();
+      group.indices.clear();
+    }
+}
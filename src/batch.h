@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+// Per frame renderer counters, shown in the HUD
+struct RenderStats
+{
+  int draw_calls = 0;     // calls actually issued to the renderer
+  int quads = 0;          // quads submitted, i.e. what one call per tile would cost
+  int chunks_rebuilt = 0;
+};
+
+// Collects colored and textured quads into vertex/index arrays grouped by
+// texture, so a whole chunk is submitted with a few `SDL_RenderGeometry` calls.
+class TileBatch
+{
+public:
+  TileBatch() { groups.emplace_back(); } // groups[0] holds the untextured quads
+
+  void push_rect(const SDL_FRect &dst, SDL_Color color);
+  void push_sprite(SDL_Texture *texture, const SDL_FRect &src, const SDL_FRect &dst, SDL_Color tint = {255, 255, 255, SDL_ALPHA_OPAQUE});
+
+  // Draw everything queued so far, colored quads first, then each texture in
+  // the order it was first used. The buffers keep their capacity between flushes.
+  void flush(SDL_Renderer *renderer, RenderStats &stats);
+
+private:
+  struct Group
+  {
+    SDL_Texture *texture = nullptr;
+    float width = 1.0f, height = 1.0f;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+  };
+
+  Group &group_for(SDL_Texture *texture);
+  static void push_quad(Group &group, const SDL_FRect &dst, SDL_FColor color, const SDL_FRect &uv);
+
+  std::vector<Group> groups;
+};
@@ -0,0 +1,137 @@
+#include "chunk.h"
+#include "profiler.h"
+
+void ChunkCache::destroy()
+{
+  while (!resident.empty()) evict(resident.back());
+  spare_textures.drain([](SDL_Texture *texture) { SDL_DestroyTexture(texture); });
+}
+
+void ChunkCache::evict(int chunk_index)
+{
+  auto &chunk = chunks[chunk_index];
+  if (!chunk.texture) return;
+
+  if (!spare_textures.release(chunk.texture)) SDL_DestroyTexture(chunk.texture);
+  chunk.texture = nullptr;
+  chunk.dirty = true;
+
+  // The last resident chunk takes the slot
+  const int last = resident.back();
+  resident[chunk.slot] = last;
+  chunks[last].slot = chunk.slot;
+  resident.pop_back();
+  chunk.slot = -1;
+}
+
+void ChunkCache::add_resident(int chunk_index)
+{
+  chunks[chunk_index].slot = static_cast<int>(resident.size());
+  resident.push_back(chunk_index);
+}
+
+void ChunkCache::mark_dirty(int tile_index)
+{
+  chunks[chunk_of(tile_index)].dirty = true;
+}
+
+void ChunkCache::mark_all_dirty()
+{
+  for (auto &chunk : chunks) chunk.dirty = true;
+}
+
+SDL_Rect ChunkCache::chunk_range(const SDL_Rect &visible)
+{
+  if (visible.w <= 0 || visible.h <= 0) return {0, 0, 0, 0};
+
+  const int x0 = visible.x / CHUNK_SIZE;
+  const int y0 = visible.y / CHUNK_SIZE;
+  const int x1 = (visible.x + visible.w - 1) / CHUNK_SIZE;
+  const int y1 = (visible.y + visible.h - 1) / CHUNK_SIZE;
+  return {x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+}
+
+int ChunkCache::rebuild(SDL_Renderer *renderer, const TileMap &tiles, const SDL_Rect &visible, SDL_Texture *atlas, RenderStats &stats)
+{
+  int rebuilt = 0;
+  SDL_Texture *target = SDL_GetRenderTarget(renderer);
+  const SDL_Rect range = chunk_range(visible);
+
+  for (int cy = range.y; cy < range.y + range.h; ++cy)
+    {
+      for (int cx = range.x; cx < range.x + range.w; ++cx)
+        {
+          const int index = cy * CHUNK_COUNT + cx;
+          if (!chunks[index].dirty) continue;
+          if (rebuild_chunk(renderer, index, tiles, atlas, stats)) ++rebuilt;
+        }
+    }
+
+  SDL_SetRenderTarget(renderer, target);
+  stats.chunks_rebuilt += rebuilt;
+  return rebuilt;
+}
+
+bool ChunkCache::rebuild_chunk(SDL_Renderer *renderer, int chunk_index, const TileMap &tiles, SDL_Texture *atlas, RenderStats &stats)
+{
+  auto &chunk = chunks[chunk_index];
+  if (!chunk.texture && spare_textures.acquire(chunk.texture))
+    {
+      add_resident(chunk_index);
+    }
+  else if (!chunk.texture)
+    {
+      chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, PIXELS, PIXELS);
+      if (!chunk.texture)
+        {
+          SDL_Log("Failed to create chunk texture: %s", SDL_GetError());
+          return false;
+        }
+      // @note: nearest keeps chunk borders seamless when zoomed
+      SDL_SetTextureScaleMode(chunk.texture, SDL_SCALEMODE_NEAREST);
+      add_resident(chunk_index);
+    }
+
+  const int cx = chunk_index % CHUNK_COUNT;
+  const int cy = chunk_index / CHUNK_COUNT;
+  const SDL_FPoint origin = {static_cast<float>(cx * PIXELS), static_cast<float>(cy * PIXELS)};
+
+  SDL_SetRenderTarget(renderer, chunk.texture);
+  SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+  SDL_SetRenderDrawColor(renderer, SDL_COLOR_RGBA(TERRAIN_COLORS[TerrainKind::Crust]));
+  SDL_RenderClear(renderer);
+  stats.draw_calls += 1;
+
+  PROFILE_ZONE("tile loop");
+  for (int y = 0; y < CHUNK_SIZE; ++y)
+    {
+      const int row = (cy * CHUNK_SIZE + y) * MAP_SIZE + cx * CHUNK_SIZE;
+      for (int x = 0; x < CHUNK_SIZE; ++x)
+        {
+          Tile{row + x}.render(batch, tiles, origin, atlas);
+        }
+    }
+  batch.flush(renderer, stats);
+
+  chunk.dirty = false;
+  return true;
+}
+
+void ChunkCache::compose(SDL_Renderer *renderer, const SDL_FRect &viewport, float zoom, const SDL_Rect &visible, RenderStats &stats) const
+{
+  const float size = PIXELS * zoom;
+  const SDL_Rect range = chunk_range(visible);
+
+  for (int cy = range.y; cy < range.y + range.h; ++cy)
+    {
+      for (int cx = range.x; cx < range.x + range.w; ++cx)
+        {
+          const auto &chunk = chunks[cy * CHUNK_COUNT + cx];
+          if (!chunk.texture) continue;
+
+          SDL_FRect dst = {viewport.x + cx * size, viewport.y + cy * size, size, size};
+          SDL_RenderTexture(renderer, chunk.texture, nullptr, &dst);
+          stats.draw_calls += 1;
+        }
+    }
+}
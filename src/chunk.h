@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+#include "batch.h"
+#include "memory.h"
+
+// The map is split in CHUNK_SIZE x CHUNK_SIZE tiles, each chunk owning a
+// cached render target. A chunk is only redrawn when one of its tiles changes,
+// and its texture only exists while the chunk is near the camera.
+struct Chunk
+{
+  SDL_Texture *texture = nullptr;
+  bool dirty = true;
+  int slot = -1; // in `resident`, while the chunk has a texture
+};
+
+class ChunkCache
+{
+public:
+  static constexpr int PIXELS = CHUNK_SIZE * TILE_SIZE;
+
+  void destroy();
+
+  void mark_dirty(int tile_index);
+  void mark_chunk_dirty(int chunk_index) { chunks[chunk_index].dirty = true; }
+  void mark_all_dirty();
+
+  // Release the texture of a chunk that went out of range, it is redrawn the
+  // next time the chunk becomes visible. Textures are kept as spares for the
+  // chunks coming into view instead of being destroyed and created again.
+  void evict(int chunk_index);
+  bool is_resident(int chunk_index) const { return chunks[chunk_index].texture != nullptr; }
+  int resident_count() const { return static_cast<int>(resident.size()); }
+  // The chunks that have a texture, in no particular order
+  const std::vector<int> &resident_chunks() const { return resident; }
+  const AllocatorStats &texture_stats() const { return spare_textures.stats(); }
+  void end_frame() { spare_textures.end_frame(); }
+
+  // Both take the visible area in tile coordinates (see `Game::visible_tiles`),
+  // chunks outside of it are neither rebuilt nor drawn.
+  // Redraw every visible dirty chunk into its texture, returns how many were rebuilt.
+  int rebuild(SDL_Renderer *renderer, const TileMap &tiles, const SDL_Rect &visible, SDL_Texture *atlas, RenderStats &stats);
+  void compose(SDL_Renderer *renderer, const SDL_FRect &viewport, float zoom, const SDL_Rect &visible, RenderStats &stats) const;
+
+  static SDL_Rect chunk_range(const SDL_Rect &visible);
+  static int chunk_of(int tile_index) { return ((tile_index / MAP_SIZE) / CHUNK_SIZE) * CHUNK_COUNT + (tile_index % MAP_SIZE) / CHUNK_SIZE; }
+
+private:
+  void add_resident(int chunk_index);
+  bool rebuild_chunk(SDL_Renderer *renderer, int chunk_index, const TileMap &tiles, SDL_Texture *atlas, RenderStats &stats);
+
+  std::array<Chunk, CHUNK_COUNT * CHUNK_COUNT> chunks;
+  TileBatch batch;
+  Pool<SDL_Texture *, CHUNK_TEXTURE_SPARES> spare_textures{"chunk textures"};
+  std::vector<int> resident;
+};
@@ -1,8 +1,45 @@
 #pragma once
 
+#include <SDL3/SDL.h>
+
 inline constexpr int TILE_SIZE = 32; // pixels
+// The world is bounded, MAP_SIZE tiles square. Chunks are generated on demand
+// as the camera gets near them, but every per-tile plane (kinds, sprites,
+// selection, simulation, fog, paths, queries) is allocated for the whole map.
+#ifdef GAME_MAP_SIZE
+inline constexpr int MAP_SIZE = GAME_MAP_SIZE; // set by the build, e.g. for the benchmarks
+#else
 inline constexpr int MAP_SIZE = 128;
+#endif
+inline constexpr int CHUNK_SIZE = 16; // tiles
+inline constexpr int CHUNK_COUNT = MAP_SIZE / CHUNK_SIZE; // chunks per axis
+inline constexpr int RESIDENCY_RADIUS = 2; // chunks kept around the visible ones
+inline constexpr int PREFETCH_BUDGET = 4; // off screen chunks generated per frame
 inline constexpr int TARGET_FPS = 30;
 inline constexpr double TARGET_FRAME_TIME = 1.0f / TARGET_FPS;
+inline constexpr double SIM_TIMESTEP = 1.0 / 60.0; // seconds per simulation update
+inline constexpr int TERRAIN_SIM_INTERVAL = 6; // simulation updates per terrain step
+inline constexpr double MAX_FRAME_DELTA = 0.25; // longer frames are clamped so the simulation can't spiral
+inline constexpr bool VSYNC = false; // pace frames with the display instead of TARGET_FPS
+inline constexpr double ASSET_UPLOAD_BUDGET = 0.004; // seconds of texture uploads per frame
+inline constexpr const char *WORLD_SAVE_PATH = "world.sav";
+inline constexpr const char *GENERATOR_CONFIG_PATH = "assets/terrain.cfg";
+inline constexpr int GENERATION_CACHE_CHUNKS = 4096; // noise kept for this many chunk fields (1 KiB each at 16x16)
+inline constexpr const char *JOURNAL_PATH = "input.jnl"; // F2 recordings
+inline constexpr float PAN_SPEED = 800.0f; // keyboard panning, screen pixels per second
+inline constexpr float MIN_ZOOM = 0.02f; // far enough to see a 512x512 map whole
+inline constexpr float MAX_ZOOM = 4.0f;
+inline constexpr float LOD_ZOOM = 0.35f; // below this the map is drawn one texel per tile
+inline constexpr float UNIT_SIZE = TILE_SIZE / 4.0f; // world pixels
+inline constexpr size_t FRAME_ARENA_SIZE = 64 * 1024; // bytes, grows to the peak if needed
+inline constexpr size_t SCRATCH_ARENA_SIZE = 1024 * 1024; // bytes, grows to the peak if needed
+inline constexpr int CHUNK_TEXTURE_SPARES = 32; // evicted chunk textures kept for reuse
+inline constexpr int UNIT_SPAWN_COUNT = 10000; // units added per key press
+inline constexpr int VIEW_RADIUS = 8; // tiles
+inline constexpr int FOG_VIEWERS = 256; // the first units see for the player
+inline constexpr int BRUSH_RADIUS = 2; // tiles, of the paint and line brushes
+inline constexpr size_t EDIT_HISTORY_SIZE = 4 * 1024 * 1024; // bytes of undo strokes, the oldest are dropped past it
+
+static_assert(MAP_SIZE % CHUNK_SIZE == 0, "MAP_SIZE must be a multiple of CHUNK_SIZE");
 
 static SDL_Color WHITE = {255, 255, 255, SDL_ALPHA_OPAQUE};
@@ -0,0 +1,121 @@
+#include "edit.h"
+
+#include <algorithm>
+
+static void put_varint(std::vector<uint8_t> &out, int value)
+{
+  while (value >= 0x80)
+    {
+      out.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+EditHistory::EditHistory(size_t capacity)
+{
+  counters.name = "edit history";
+  counters.capacity = capacity;
+}
+
+void EditHistory::begin()
+{
+  pending.runs.clear();
+  pending.tiles = 0;
+  run_count = run_end = 0;
+  left = MAP_SIZE;
+  right = -1;
+}
+
+void EditHistory::record(int index, TerrainKind before, TerrainKind after)
+{
+  const uint8_t kinds = static_cast<uint8_t>(before | after << 4);
+  if (run_count > 0 && index == run_first + run_count && kinds == run_kinds)
+    {
+      ++run_count;
+    }
+  else
+    {
+      flush_run();
+      if (pending.tiles == 0) pending.bounds.y = index / MAP_SIZE;
+      run_first = index;
+      run_count = 1;
+      run_kinds = kinds;
+    }
+
+  // Rows come in order, only the columns need tracking
+  const int x = index % MAP_SIZE;
+  left = std::min(left, x);
+  right = std::max(right, x);
+  pending.bounds.h = index / MAP_SIZE - pending.bounds.y + 1;
+  ++pending.tiles;
+}
+
+void EditHistory::flush_run()
+{
+  if (run_count == 0) return;
+
+  put_varint(pending.runs, run_first - run_end);
+  put_varint(pending.runs, run_count);
+  pending.runs.push_back(run_kinds);
+  run_end = run_first + run_count;
+  run_count = 0;
+}
+
+const EditStroke *EditHistory::commit()
+{
+  flush_run();
+  if (pending.tiles == 0) return nullptr;
+
+  pending.bounds.x = left;
+  pending.bounds.w = right - left + 1;
+
+  // Nothing undone can be redone over a new stroke
+  while (strokes.size() > done)
+    {
+      bytes -= strokes.back().runs.size();
+      strokes.pop_back();
+    }
+
+  // Copied to an exact fit, `pending` keeps its capacity for the next stroke
+  strokes.push_back({std::vector<uint8_t>(pending.runs.begin(), pending.runs.end()), pending.bounds, pending.tiles});
+  bytes += pending.runs.size();
+  while (bytes > counters.capacity && strokes.size() > 1)
+    {
+      bytes -= strokes.front().runs.size();
+      strokes.pop_front();
+      ++counters.misses;
+    }
+  done = strokes.size();
+
+  ++counters.allocations;
+  counters.used = bytes;
+  counters.peak = std::max(counters.peak, bytes);
+  return &strokes.back();
+}
+
+const EditStroke *EditHistory::undo()
+{
+  if (done == 0) return nullptr;
+  return &strokes[--done];
+}
+
+const EditStroke *EditHistory::redo()
+{
+  if (done == strokes.size()) return nullptr;
+  return &strokes[done++];
+}
+
+void EditHistory::clear()
+{
+  strokes.clear();
+  done = 0;
+  bytes = 0;
+  counters.used = 0;
+}
+
+void EditHistory::end_frame()
+{
+  counters.last_allocations = counters.allocations;
+  counters.allocations = 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+#include "memory.h"
+
+static_assert(TERRAIN_KIND_COUNT <= 16, "a run packs both kinds in one byte");
+
+// The tiles one brush stroke changed, as runs in index order. Each run is
+//
+//   gap, count  varints: tiles skipped since the end of the previous run, and
+//               tiles in the run
+//   kinds       one byte: kind before | kind after << 4
+//
+// so a stroke takes a few bytes per row it crosses, however many tiles it
+// covers.
+struct EditStroke
+{
+  std::vector<uint8_t> runs;
+  SDL_Rect bounds = {0}; // of the changed tiles
+  int tiles = 0;
+};
+
+// Undo/redo journal of terrain edits. A stroke is recorded tile by tile with
+// `record` between `begin` and `commit`, in increasing index order. Committing
+// drops the strokes that were undone, and the oldest ones once the journal is
+// over its capacity in bytes. The newest stroke is always kept.
+class EditHistory
+{
+public:
+  explicit EditHistory(size_t capacity = EDIT_HISTORY_SIZE);
+
+  void begin();
+  void record(int index, TerrainKind before, TerrainKind after);
+  // The stroke to apply, null when it changed nothing
+  const EditStroke *commit();
+
+  // The stroke to revert or apply again, null when there's none
+  const EditStroke *undo();
+  const EditStroke *redo();
+  void clear();
+
+  bool can_undo() const { return done > 0; }
+  bool can_redo() const { return done < strokes.size(); }
+
+  // Calls `visit(first, count, before, after)` for every run of `stroke`
+  template <typename Visit>
+  static void for_each_run(const EditStroke &stroke, Visit &&visit)
+  {
+    const uint8_t *p = stroke.runs.data();
+    const uint8_t *end = p + stroke.runs.size();
+    int index = 0;
+    while (p < end)
+      {
+        index += read_varint(p);
+        const int count = read_varint(p);
+        const uint8_t kinds = *p++;
+        visit(index, count, static_cast<TerrainKind>(kinds & 0xf), static_cast<TerrainKind>(kinds >> 4));
+        index += count;
+      }
+  }
+
+  // Bytes of the kept strokes. Misses are strokes dropped for room.
+  const AllocatorStats &stats() const { return counters; }
+  void end_frame();
+
+private:
+  static int read_varint(const uint8_t *&p)
+  {
+    int value = 0;
+    for (int shift = 0;; shift += 7)
+      {
+        const uint8_t byte = *p++;
+        value |= (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+      }
+  }
+
+  void flush_run();
+
+  std::deque<EditStroke> strokes;
+  size_t done = 0; // strokes applied, the ones after were undone
+  size_t bytes = 0;
+
+  // Stroke being recorded
+  EditStroke pending;
+  int run_first = 0, run_count = 0, run_end = 0;
+  uint8_t run_kinds = 0;
+  int left = 0, right = 0;
+
+  AllocatorStats counters;
+};
@@ -0,0 +1,186 @@
+#include "entity.h"
+#include "path.h"
+
+#include <algorithm>
+
+EntityId EntityStore::spawn(SDL_FPoint position, SDL_FPoint velocity, uint8_t sprite_index)
+{
+  uint32_t id;
+  if (!free_ids.empty())
+    {
+      id = free_ids.back();
+      free_ids.pop_back();
+    }
+  else
+    {
+      id = static_cast<uint32_t>(dense.size());
+      dense.push_back(0);
+      generations.push_back(0);
+    }
+
+  const int entity = size();
+  dense[id] = entity;
+  ids.push_back(id);
+
+  x.push_back(position.x);
+  y.push_back(position.y);
+  px.push_back(position.x);
+  py.push_back(position.y);
+  vx.push_back(velocity.x);
+  vy.push_back(velocity.y);
+  sprite.push_back(sprite_index);
+  tile.push_back(-1);
+  next.push_back(-1);
+  prev.push_back(-1);
+
+  const int tx = std::clamp(static_cast<int>(position.x / TILE_SIZE), 0, MAP_SIZE - 1);
+  const int ty = std::clamp(static_cast<int>(position.y / TILE_SIZE), 0, MAP_SIZE - 1);
+  link(entity, ty * MAP_SIZE + tx);
+
+  return {id, generations[id]};
+}
+
+bool EntityStore::alive(EntityId id) const
+{
+  return id.index < generations.size() && generations[id.index] == id.generation && dense[id.index] < ids.size()
+    && ids[dense[id.index]] == id.index;
+}
+
+void EntityStore::destroy(EntityId id)
+{
+  if (!alive(id)) return;
+
+  const int entity = dense[id.index];
+  const int last = size() - 1;
+  unlink(entity);
+
+  if (entity != last)
+    {
+      const int last_tile = tile[last];
+      unlink(last);
+
+      x[entity] = x[last];
+      y[entity] = y[last];
+      px[entity] = px[last];
+      py[entity] = py[last];
+      vx[entity] = vx[last];
+      vy[entity] = vy[last];
+      sprite[entity] = sprite[last];
+      ids[entity] = ids[last];
+      dense[ids[entity]] = entity;
+      link(entity, last_tile);
+    }
+
+  x.pop_back();
+  y.pop_back();
+  px.pop_back();
+  py.pop_back();
+  vx.pop_back();
+  vy.pop_back();
+  sprite.pop_back();
+  tile.pop_back();
+  next.pop_back();
+  prev.pop_back();
+  ids.pop_back();
+
+  ++generations[id.index];
+  free_ids.push_back(id.index);
+}
+
+void EntityStore::clear()
+{
+  for (uint32_t id : ids)
+    {
+      ++generations[id];
+      free_ids.push_back(id);
+    }
+
+  x.clear();
+  y.clear();
+  px.clear();
+  py.clear();
+  vx.clear();
+  vy.clear();
+  sprite.clear();
+  tile.clear();
+  next.clear();
+  prev.clear();
+  ids.clear();
+  std::fill(head.begin(), head.end(), -1);
+}
+
+void EntityStore::link(int entity, int tile_index)
+{
+  tile[entity] = tile_index;
+  prev[entity] = -1;
+  next[entity] = head[tile_index];
+  if (head[tile_index] >= 0) prev[head[tile_index]] = entity;
+  head[tile_index] = entity;
+}
+
+void EntityStore::unlink(int entity)
+{
+  if (prev[entity] >= 0) next[prev[entity]] = next[entity];
+  else head[tile[entity]] = next[entity];
+  if (next[entity] >= 0) prev[next[entity]] = prev[entity];
+}
+
+int EntityStore::count_in_tile(int tile_index) const
+{
+  int count = 0;
+  for (int entity = head[tile_index]; entity >= 0; entity = next[entity]) ++count;
+  return count;
+}
+
+void EntityStore::update(float dt, const TileMap &tiles)
+{
+  const int count = size();
+  if (count == 0) return;
+
+  std::copy(x.begin(), x.end(), px.begin());
+  std::copy(y.begin(), y.end(), py.begin());
+
+  // @note: the first two loops are branch free over plain float arrays so the
+  // compiler can vectorize them, everything per entity is in the last one
+  float *__restrict X = x.data();
+  float *__restrict Y = y.data();
+  float *__restrict VX = vx.data();
+  float *__restrict VY = vy.data();
+  const float limit = static_cast<float>(MAP_SIZE * TILE_SIZE) - 0.01f;
+
+  for (int i = 0; i < count; ++i)
+    {
+      const float nx = X[i] + VX[i] * dt;
+      const float ny = Y[i] + VY[i] * dt;
+      VX[i] = (nx < 0.0f || nx > limit) ? -VX[i] : VX[i];
+      VY[i] = (ny < 0.0f || ny > limit) ? -VY[i] : VY[i];
+      X[i] = std::min(std::max(nx, 0.0f), limit);
+      Y[i] = std::min(std::max(ny, 0.0f), limit);
+    }
+
+  moved_tile.resize(count);
+  int *__restrict T = moved_tile.data();
+  constexpr float INV_TILE = 1.0f / TILE_SIZE;
+  for (int i = 0; i < count; ++i)
+    {
+      T[i] = static_cast<int>(Y[i] * INV_TILE) * MAP_SIZE + static_cast<int>(X[i] * INV_TILE);
+    }
+
+  for (int i = 0; i < count; ++i)
+    {
+      if (T[i] == tile[i]) continue;
+
+      if (!TERRAIN_COST[tiles.kinds[T[i]]])
+        {
+          // Step back and turn around
+          x[i] = px[i];
+          y[i] = py[i];
+          vx[i] = -vx[i];
+          vy[i] = -vy[i];
+          continue;
+        }
+
+      unlink(i);
+      link(i, T[i]);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+
+// Stable reference to an entity, stale once the entity is destroyed
+struct EntityId
+{
+  uint32_t index = 0;
+  uint32_t generation = 0;
+};
+
+const SDL_Color UNIT_COLORS[] = {
+    {0xe6, 0x39, 0x46, SDL_ALPHA_OPAQUE},
+    {0xf1, 0xfa, 0xee, SDL_ALPHA_OPAQUE},
+    {0x45, 0x7b, 0x9d, SDL_ALPHA_OPAQUE},
+    {0xff, 0xb7, 0x03, SDL_ALPHA_OPAQUE},
+};
+inline constexpr int UNIT_COLOR_COUNT = sizeof(UNIT_COLORS) / sizeof(UNIT_COLORS[0]);
+
+// Units walking on the map. Every unit has the same components, so there is a
+// single archetype stored as parallel arrays (SoA), packed: entity `i` of the
+// arrays is the i-th live entity and destroying one moves the last into its
+// place. Positions are in world pixels.
+//
+// Every tile keeps an intrusive list of the entities standing on it, relinked
+// only when an entity crosses into another tile.
+class EntityStore
+{
+public:
+  EntityId spawn(SDL_FPoint position, SDL_FPoint velocity, uint8_t sprite);
+  void destroy(EntityId id);
+  bool alive(EntityId id) const;
+  void clear();
+  int size() const { return static_cast<int>(x.size()); }
+
+  // Move everything by `dt` seconds. Units bounce off the map edges and off
+  // impassable tiles.
+  void update(float dt, const TileMap &tiles);
+
+  int first_in_tile(int tile) const { return head[tile]; } // -1 when empty
+  int next_in_tile(int entity) const { return next[entity]; }
+  int count_in_tile(int tile) const;
+
+  // Components, indexed by dense entity
+  std::vector<float> x, y;   // position
+  std::vector<float> px, py; // position before the last update, to interpolate
+  std::vector<float> vx, vy; // velocity, pixels per second
+  std::vector<uint8_t> sprite;
+  std::vector<int> tile;
+
+private:
+  void link(int entity, int tile_index);
+  void unlink(int entity);
+
+  // Spatial index: per tile list heads, per entity links
+  std::vector<int> head = std::vector<int>(TILE_COUNT, -1);
+  std::vector<int> next, prev;
+
+  // dense -> id, id -> dense and the ids free for reuse
+  std::vector<uint32_t> ids;
+  std::vector<uint32_t> dense, generations;
+  std::vector<uint32_t> free_ids;
+
+  std::vector<int> moved_tile; // update scratch
+};
@@ -1,8 +1,35 @@
 #include "events.h"
 #include <algorithm>
 
+// Shift adds to the selection, Ctrl removes from it and Alt keeps the overlap
+static SelectOp select_op()
+{
+  const SDL_Keymod mods = SDL_GetModState();
+  if (mods & SDL_KMOD_SHIFT) return SelectOp::Union;
+  if (mods & SDL_KMOD_CTRL) return SelectOp::Subtract;
+  if (mods & SDL_KMOD_ALT) return SelectOp::Intersect;
+  return SelectOp::Replace;
+}
+
 SDL_AppResult handle_events(Game &game, SDL_Event *event)
 {
+  // Replayed input skips the debug windows: where they are isn't in the journal,
+  // and the headless replay has none
+  if (ImGui::GetCurrentContext() && !game.journal.is_replaying())
+    {
+      ImGui_ImplSDL3_ProcessEvent(event);
+
+      // Don't click through the debug windows
+      const bool mouse_event = event->type == SDL_EVENT_MOUSE_BUTTON_DOWN
+        || event->type == SDL_EVENT_MOUSE_BUTTON_UP
+        || event->type == SDL_EVENT_MOUSE_WHEEL;
+      if (mouse_event && ImGui::GetIO().WantCaptureMouse) return SDL_APP_CONTINUE;
+    }
+
+  // F2 toggles the recording itself, replaying it would start a new one
+  const bool journal_key = event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_F2;
+  if (!journal_key) game.journal.record(*event, game.sim_ticks);
+
   switch (event->type)
   {
   case SDL_EVENT_QUIT:
@@ -22,7 +49,11 @@ SDL_AppResult handle_events(Game &game, SDL_Event *event)
   case SDL_EVENT_KEY_DOWN:
   {
     SDL_KeyboardEvent key = event->key;
-    if (key.key == SDLK_Q)
+    if (key.key == SDLK_LEFT)       game.pan_left = true;
+    else if (key.key == SDLK_RIGHT) game.pan_right = true;
+    else if (key.key == SDLK_UP)    game.pan_up = true;
+    else if (key.key == SDLK_DOWN)  game.pan_down = true;
+    else if (key.key == SDLK_Q)
     {
       return SDL_APP_SUCCESS; // Terminate app gracefully
     }
@@ -30,6 +61,96 @@ SDL_AppResult handle_events(Game &game, SDL_Event *event)
     {
       game.render_grid = !game.render_grid;
     }
+    else if (key.key == SDLK_P)
+    {
+      game.show_profiler = !game.show_profiler;
+    }
+    else if (key.key == SDLK_M)
+    {
+      game.show_memory = !game.show_memory;
+    }
+    else if (key.key == SDLK_T)
+    {
+      profiler.export_chrome_trace("trace.json", Profiler::FRAME_COUNT - 1);
+    }
+    else if (key.key == SDLK_L)
+    {
+      game.select_mode = game.select_mode == Game::SELECT_BOX ? Game::SELECT_LASSO : Game::SELECT_BOX;
+    }
+    else if (key.key == SDLK_B)
+    {
+      game.brush = static_cast<Game::BrushMode>((game.brush + 1) % Game::BRUSH_COUNT);
+    }
+    else if (key.key >= SDLK_0 && key.key < SDLK_0 + TERRAIN_KIND_COUNT)
+    {
+      game.brush_kind = static_cast<TerrainKind>(key.key - SDLK_0);
+    }
+    else if (key.key == SDLK_LEFTBRACKET)
+    {
+      game.brush_radius = std::max(0, game.brush_radius - 1);
+    }
+    else if (key.key == SDLK_RIGHTBRACKET)
+    {
+      game.brush_radius = std::min(MAP_SIZE / 2, game.brush_radius + 1);
+    }
+    else if (key.key == SDLK_Z && (key.mod & SDL_KMOD_CTRL))
+    {
+      if (key.mod & SDL_KMOD_SHIFT) game.redo_edit();
+      else                          game.undo_edit();
+    }
+    else if (key.key == SDLK_Y && (key.mod & SDL_KMOD_CTRL))
+    {
+      game.redo_edit();
+    }
+    else if (key.key == SDLK_I)
+    {
+      game.invert_selection();
+    }
+    else if (key.key == SDLK_ESCAPE)
+    {
+      game.select_shape.clear();
+      game.select(game.select_shape, SelectOp::Replace);
+    }
+    else if (key.key == SDLK_O)
+    {
+      game.show_fog = !game.show_fog;
+    }
+    else if (key.key == SDLK_W)
+    {
+      game.simulate_terrain = !game.simulate_terrain;
+    }
+    else if (key.key == SDLK_U)
+    {
+      game.spawn_units(UNIT_SPAWN_COUNT, static_cast<uint32_t>(game.sim_ticks));
+    }
+    else if (key.key == SDLK_F2)
+    {
+      if (game.journal.is_recording()) game.journal.stop_recording();
+      else                              game.start_recording(JOURNAL_PATH);
+    }
+    else if (key.key == SDLK_F6)
+    {
+      // Regenerate with the edited generator settings, same seed
+      if (game.load_generator(GENERATOR_CONFIG_PATH)) game.initialize_map(game.generator.seed);
+    }
+    else if (key.key == SDLK_F5)
+    {
+      game.save_world(WORLD_SAVE_PATH);
+    }
+    else if (key.key == SDLK_F9)
+    {
+      game.load_world(WORLD_SAVE_PATH);
+    }
+    break;
+  }
+
+  case SDL_EVENT_KEY_UP:
+  {
+    SDL_KeyboardEvent key = event->key;
+    if (key.key == SDLK_LEFT)       game.pan_left = false;
+    else if (key.key == SDLK_RIGHT) game.pan_right = false;
+    else if (key.key == SDLK_UP)    game.pan_up = false;
+    else if (key.key == SDLK_DOWN)  game.pan_down = false;
     break;
   }
 
@@ -39,7 +160,7 @@ SDL_AppResult handle_events(Game &game, SDL_Event *event)
     // @todo: handle flipped SDL_MOUSEWHEEL_FLIPPED
     if (wheel.direction == SDL_MOUSEWHEEL_NORMAL && wheel.y != 0)
     {
-      game.handle_mouse_wheel(wheel.integer_x, wheel.integer_y, wheel.y);
+      game.handle_mouse_wheel(static_cast<int>(wheel.mouse_x), static_cast<int>(wheel.mouse_y), wheel.y);
     }
     break;
   }
@@ -53,6 +174,11 @@ SDL_AppResult handle_events(Game &game, SDL_Event *event)
       game.snap_offset.x = mouse.x;
       game.snap_offset.y = mouse.y;
     }
+    else if (mouse.button == SDL_BUTTON_LEFT && mouse.down)
+    {
+      if (game.brush != Game::BRUSH_OFF) game.begin_stroke({mouse.x, mouse.y});
+      else                               game.begin_selection({mouse.x, mouse.y});
+    }
     break;
   }
 
@@ -67,7 +193,14 @@ SDL_AppResult handle_events(Game &game, SDL_Event *event)
       }
     else if (mouse.button == SDL_BUTTON_LEFT)
       {
-        game.tile_on_mouse->selected = !game.tile_on_mouse->selected;
+        game.end_stroke();
+        game.end_selection(select_op());
+      }
+    else if (mouse.button == SDL_BUTTON_RIGHT)
+      {
+        // Right click picks where the path preview starts, again to turn it off
+        const int tile = game.tile_at(game.screen_to_world({mouse.x, mouse.y}));
+        game.path_start = tile == game.path_start ? -1 : tile;
       }
 
     break;
@@ -80,6 +213,8 @@ SDL_AppResult handle_events(Game &game, SDL_Event *event)
     {
       game.handle_snapping(motion);
     }
+    game.extend_selection({motion.x, motion.y});
+    game.extend_stroke({motion.x, motion.y});
     SDL_FPoint p = {motion.x, motion.y};
     if (SDL_PointInRectFloat(&p, &game.viewport))
     {
@@ -2,6 +2,7 @@
 
 #include <SDL3/SDL.h>
 
+#include <imgui.h>
 #include <backends/imgui_impl_sdl3.h>
 
 #include "game.h"
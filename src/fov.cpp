@@ -0,0 +1,176 @@
+#include "fov.h"
+
+// (xx, xy, yx, yy) mapping the first octant's (dx, dy) onto each octant
+static constexpr int OCTANTS[8][4] = {
+  {1, 0, 0, -1}, {0, 1, -1, 0}, {0, -1, -1, 0}, {-1, 0, 0, -1},
+  {-1, 0, 0, 1}, {0, -1, 1, 0}, {0, 1, 1, 0}, {1, 0, 0, 1},
+};
+
+void FogOfWar::resize(int count)
+{
+  for (int slot = count; slot < static_cast<int>(viewers.size()); ++slot)
+    {
+      unsee(viewers[slot]);
+    }
+  viewers.resize(count);
+}
+
+void FogOfWar::set_viewer(int slot, int tile, int radius)
+{
+  Viewer &viewer = viewers[slot];
+  if (viewer.tile == tile && viewer.radius == radius) return;
+
+  viewer.tile = tile;
+  viewer.radius = radius;
+  viewer.dirty = true;
+}
+
+void FogOfWar::clear()
+{
+  viewers.clear();
+  std::fill(seen_count.begin(), seen_count.end(), 0);
+  std::fill(dirty_chunks.begin(), dirty_chunks.end(), 0);
+  visible.clear();
+  explored.clear();
+  changed = true;
+}
+
+bool FogOfWar::near_dirty_chunk(const Viewer &viewer) const
+{
+  const int x = viewer.tile % MAP_SIZE, y = viewer.tile / MAP_SIZE;
+  const int cx0 = std::max(0, x - viewer.radius) / CHUNK_SIZE, cx1 = std::min(MAP_SIZE - 1, x + viewer.radius) / CHUNK_SIZE;
+  const int cy0 = std::max(0, y - viewer.radius) / CHUNK_SIZE, cy1 = std::min(MAP_SIZE - 1, y + viewer.radius) / CHUNK_SIZE;
+  for (int cy = cy0; cy <= cy1; ++cy)
+    {
+      for (int cx = cx0; cx <= cx1; ++cx)
+        {
+          if (dirty_chunks[cy * CHUNK_COUNT + cx]) return true;
+        }
+    }
+  return false;
+}
+
+int FogOfWar::update()
+{
+  int recomputed = 0;
+  const bool any_dirty_chunk = std::find(dirty_chunks.begin(), dirty_chunks.end(), 1) != dirty_chunks.end();
+
+  for (Viewer &viewer : viewers)
+    {
+      if (!viewer.dirty && !(any_dirty_chunk && viewer.tile >= 0 && near_dirty_chunk(viewer))) continue;
+      recompute(viewer);
+      ++recomputed;
+    }
+  if (any_dirty_chunk) std::fill(dirty_chunks.begin(), dirty_chunks.end(), 0);
+
+  if (changed)
+    {
+      // Whole words at a time, cheap next to walking the tiles when drawing
+      for (int i = 0; i < TileBits::WORDS; ++i)
+        {
+          hidden.words[i] = ~explored.words[i];
+          remembered.words[i] = explored.words[i] & ~visible.words[i];
+        }
+      changed = false;
+    }
+  return recomputed;
+}
+
+// Takes back the viewer's tiles, those nobody else sees leave `visible`
+void FogOfWar::unsee(Viewer &viewer)
+{
+  for (int index : viewer.seen)
+    {
+      if (--seen_count[index] == 0)
+        {
+          visible.flip(index);
+          changed = true;
+        }
+    }
+  viewer.seen.clear();
+}
+
+void FogOfWar::see(Viewer &viewer, int x, int y)
+{
+  const int index = y * MAP_SIZE + x;
+  if (marks[index] == stamp) return;
+  marks[index] = stamp;
+
+  viewer.seen.push_back(index);
+  if (seen_count[index]++ == 0)
+    {
+      visible.flip(index);
+      if (!explored.test(index)) explored.flip(index);
+      changed = true;
+    }
+}
+
+void FogOfWar::recompute(Viewer &viewer)
+{
+  viewer.dirty = false;
+  unsee(viewer);
+  if (viewer.tile < 0) return;
+
+  if (++stamp == 0)
+    {
+      // Wrapped, old marks could match again
+      std::fill(marks.begin(), marks.end(), 0);
+      stamp = 1;
+    }
+
+  see(viewer, viewer.tile % MAP_SIZE, viewer.tile / MAP_SIZE);
+  for (const int *octant : OCTANTS)
+    {
+      cast(viewer, 1, 1.0f, 0.0f, octant);
+    }
+}
+
+// Recursive shadowcasting over one octant: rows of increasing distance are
+// scanned between the slopes `start` and `end`. An opaque run splits the
+// scan, the part before it goes on in a recursive call.
+void FogOfWar::cast(Viewer &viewer, int row, float start, float end, const int *octant)
+{
+  if (start < end) return;
+
+  const int cx = viewer.tile % MAP_SIZE, cy = viewer.tile / MAP_SIZE;
+  const int radius = viewer.radius;
+  float next_start = start;
+
+  for (int distance = row; distance <= radius; ++distance)
+    {
+      bool blocked = false;
+      for (int dx = -distance, dy = -distance; dx <= 0; ++dx)
+        {
+          const float left = (dx - 0.5f) / (dy + 0.5f);
+          const float right = (dx + 0.5f) / (dy - 0.5f);
+          if (start < right) continue;
+          if (end > left) break;
+
+          const int x = cx + dx * octant[0] + dy * octant[1];
+          const int y = cy + dx * octant[2] + dy * octant[3];
+          const bool inside = x >= 0 && y >= 0 && x < MAP_SIZE && y < MAP_SIZE;
+          // Off the map blocks sight like a wall
+          const bool opaque = !inside || TERRAIN_OPAQUE[tiles.kinds[y * MAP_SIZE + x]];
+
+          if (inside && dx * dx + dy * dy <= radius * radius) see(viewer, x, y);
+
+          if (blocked)
+            {
+              if (opaque)
+                {
+                  next_start = right;
+                  continue;
+                }
+              blocked = false;
+              start = next_start;
+            }
+          else if (opaque && distance < radius)
+            {
+              blocked = true;
+              cast(viewer, distance + 1, start, left, octant);
+              next_start = right;
+            }
+        }
+      if (blocked) break;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+#include "selection.h"
+
+// Kinds that block sight. They are seen themselves, what is behind isn't.
+inline constexpr bool TERRAIN_OPAQUE[TERRAIN_KIND_COUNT] = {
+    true,  // Crust
+    false, // Water
+    false, // Dirt
+    false, // Grass
+    false, // Sand
+    false, // Snow
+    true,  // Forest
+    true,  // Mountain
+    false, // Swamp
+    false, // Lava
+};
+
+// Fog of war of one player: what its viewers see right now (`visible`) and
+// everything they have seen so far (`explored`), one bit per tile.
+//
+// Every viewer keeps the tiles it sees, found by recursive shadowcasting, and
+// every tile counts the viewers seeing it. A viewer is only recomputed when it
+// moves to another tile or the sight blocking terrain around it changes, which
+// takes its old tiles back and adds the new ones. The others cost nothing.
+class FogOfWar
+{
+public:
+  explicit FogOfWar(const TileMap &tiles) : tiles(tiles) {}
+
+  // Viewers are numbered slots. Slots from `count` on are removed.
+  void resize(int count);
+  // Put a viewer on a tile, -1 to leave it without sight
+  void set_viewer(int slot, int tile, int radius = VIEW_RADIUS);
+  // Drop every viewer and what was explored, e.g. for a new map
+  void clear();
+
+  // Terrain changed whether it blocks sight, the viewers that may see it are
+  // recomputed. Tracked by chunk, so some viewers near it are recomputed for
+  // nothing.
+  void mark_dirty(int index) { mark_chunk_dirty(chunk_of(index)); }
+  void mark_chunk_dirty(int chunk_index) { dirty_chunks[chunk_index] = 1; }
+
+  // Recompute the viewers that moved or whose surroundings changed, returns
+  // how many were
+  int update();
+
+  TileBits visible, explored;
+  // Derived by `update`, for drawing: never seen, and seen but not in sight
+  TileBits hidden, remembered;
+
+private:
+  struct Viewer
+  {
+    int tile = -1;
+    int radius = 0;
+    bool dirty = false;
+    std::vector<int> seen;
+  };
+
+  static int chunk_of(int index) { return ((index / MAP_SIZE) / CHUNK_SIZE) * CHUNK_COUNT + (index % MAP_SIZE) / CHUNK_SIZE; }
+
+  void recompute(Viewer &viewer);
+  void unsee(Viewer &viewer);
+  void cast(Viewer &viewer, int row, float start, float end, const int *octant);
+  void see(Viewer &viewer, int x, int y);
+  bool near_dirty_chunk(const Viewer &viewer) const;
+
+  const TileMap &tiles;
+  std::vector<Viewer> viewers;
+  std::vector<uint16_t> seen_count = std::vector<uint16_t>(TILE_COUNT, 0);
+  std::vector<uint8_t> dirty_chunks = std::vector<uint8_t>(CHUNK_COUNT * CHUNK_COUNT, 0);
+  // Stamped with `stamp` once seen by the viewer being computed, octants overlap
+  std::vector<uint32_t> marks = std::vector<uint32_t>(TILE_COUNT, 0);
+  uint32_t stamp = 0;
+  bool changed = true; // `visible` or `explored` since the last update
+};
@@ -1,93 +1,221 @@
 #include "game.h"
+#include "events.h"
+
+#include <imgui.h>
+#include <backends/imgui_impl_sdl3.h>
+#include <backends/imgui_impl_sdlrenderer3.h>
 
 bool Game::create_world()
 {
-  if (!assets.load_texture(renderer, "bg",    "assets/bg.png"))            return false;
-  if (!assets.load_texture(renderer, "grass", "assets/tileset_grass.png")) return false;
-  if (!assets.load_texture(renderer, "frame", "assets/frame.png"))         return false;
-  
-  world_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
-  // @note: set it for transparency
-  // SDL_SetTextureBlendMode(ctx->world_texture, SDL_BLENDMODE_BLEND);
-  
-  if (!world_texture) {
-    SDL_Log("Failed to create world canvas: %s", SDL_GetError());
-    return false;
-  }
+  jobs.start(std::max(1, SDL_GetNumLogicalCPUCores() - 1));
+
+  // Decoded in the background, the map is drawn without them until they are in
+  bg_texture    = assets.load_texture(jobs, "assets/bg.png");
+  grass_texture = assets.load_texture(jobs, "assets/tileset_grass.png");
+  frame_texture = assets.load_texture(jobs, "assets/frame.png");
   
+  if (!text_engine.create(renderer, font)) return false;
+
+  // The built-in graph is used when the file is missing or broken
+  load_generator(GENERATOR_CONFIG_PATH);
+
   viewport = {0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)};
+  prev_camera = {viewport.x, viewport.y};
   prev_time = SDL_GetPerformanceCounter();
   curr_time = prev_time;
 
   return true;      
 }
 
+// Chunks are generated lazily by `stream_world` as the camera gets near them,
+// so this only resets the world to a new seed.
 void Game::initialize_map(int noise_seed)
 {
-  auto fnSimplex = FastNoise::New<FastNoise::Simplex>();
-  auto noise_generator = FastNoise::New<FastNoise::DomainScale>();
+  generator.reset(jobs, tiles, noise_seed);
+  std::fill(unsaved.begin(), unsaved.end(), 0);
+  tiles.clear_selection();
+  sim.reset();
+  fog.clear();
+  history.clear();
+  terrain.invalidate();
+  paths.invalidate();
+  path_start = -1;
+  units.clear();
+  chunks.mark_all_dirty();
+  lod.mark_all_dirty();
+}
 
-  // fnSimplex->GenUniformGrid2D(noise_map, 0, 0, MAP_SIZE, MAP_SIZE, 0.09f, seed);
-  noise_generator->SetSource(fnSimplex);
-  // noise_generator->SetGain(0.6f);
-  // noise_generator->SetLacunarity(2.0f);
-  // noise_generator->SetOctaveCount(4);
-  noise_generator->SetScale(0.2f);
-    
-  float noise_map[MAP_SIZE * MAP_SIZE] = {0};
-  noise_generator->GenUniformGrid2D(noise_map, 0, 0, MAP_SIZE, MAP_SIZE, 1.0f, noise_seed);
-  // noise_generator->GenSingle2D(noise_map, 0, 0, MAP_SIZE, MAP_SIZE, 1.0f, noise_seed);
+// Swaps the generator graph and rules, the map has to be reinitialized to see
+// them. Noise already sampled with the same graph and seed comes from the cache.
+bool Game::load_generator(const std::string &path)
+{
+  GeneratorConfig config;
+  if (!config.load(path)) return false;
+
+  jobs.wait_idle();
+  if (!generator.configure(config)) return false;
 
-  for (size_t index = 0; index < tiles.size(); ++index)
+  // The open save can't be extended by chunks of the new settings, the next
+  // save writes a complete file instead
+  if (world_file.is_open() && world_file.generator_hash() != config.hash()) world_file.close();
+  return true;
+}
+
+// Generate the whole map up front, blocking until every chunk is done
+void Game::generate_all()
+{
+  for (int index = 0; index < CHUNK_COUNT * CHUNK_COUNT; ++index)
     {
-      auto &tile = tiles[index];
+      request_chunk(index);
+    }
+  jobs.wait_idle();
 
-      float fx = static_cast<float>(index % MAP_SIZE);
-      float fy = static_cast<float>(index / MAP_SIZE);
+  collect_generated();
+}
 
-      tile.coord.x = static_cast<int>(fx);
-      tile.coord.y = static_cast<int>(fy);
+// Chunks stored in the open save are decoded right away, the others are
+// generated on the worker pool
+void Game::request_chunk(int chunk_index)
+{
+  if (generator.state(chunk_index) != ChunkState::Empty) return;
+
+  if (world_file.load_chunk(chunk_index, tiles))
+    {
+      generator.mark_ready(chunk_index);
+      finish_chunk(chunk_index);
+      return;
+    }
+
+  generator.request(jobs, chunk_index);
+}
 
-      tile.rect = {
-        static_cast<float>(tile.coord.x) * TILE_SIZE,
-        static_cast<float>(tile.coord.y) * TILE_SIZE,
-        static_cast<float>(TILE_SIZE),
-        static_cast<float>(TILE_SIZE)};
+void Game::collect_generated()
+{
+  for (int index : generator.collect_finished(tiles))
+    {
+      unsaved[index] = 1;
+      finish_chunk(index);
+    }
+}
 
-      // float noise = noise_generator->GenSingle2D(fx, fy, noise_seed);
-      float noise = noise_map[index];
-      noise = fabs(noise);
+// Saving over the open file only appends the chunks that changed, saving
+// anywhere else writes a complete (and compacted) file
+bool Game::save_world(const std::string &path)
+{
+  std::vector<int> changed;
+  for (int index = 0; index < CHUNK_COUNT * CHUNK_COUNT; ++index)
+    {
+      if (unsaved[index]) changed.push_back(index);
+    }
 
-      if (noise <= 0.2f)
+  bool ok;
+  if (world_file.is_open() && world_file.path() == path)
+    {
+      ok = world_file.append(tiles, changed);
+    }
+  else
+    {
+      std::vector<uint8_t> stored(CHUNK_COUNT * CHUNK_COUNT, 0);
+      for (int index = 0; index < CHUNK_COUNT * CHUNK_COUNT; ++index)
         {
-          tile.kind = TerrainKind::Crust;
+          stored[index] = generator.is_generated(index);
         }
-      // else if (noise < 0.6f)
-      //   {
-      //     tile.kind = TerrainKind::Dirt;
-      //   }
-      else
+      ok = WorldFile::write(path, generator.seed, generator.config().hash(), tiles, stored, &world_file) && world_file.open(path);
+    }
+
+  if (ok)
+    {
+      std::fill(unsaved.begin(), unsaved.end(), 0);
+      SDL_Log("Saved %zu changed chunks to '%s'", changed.size(), path.c_str());
+    }
+  return ok;
+}
+
+// Chunks are decoded lazily, as `stream_world` asks for them
+bool Game::load_world(const std::string &path)
+{
+  // Drop the jobs of the current world before its file goes away
+  jobs.wait_idle();
+  if (!world_file.open(path)) return false;
+
+  // The chunks that aren't stored would come from another generator
+  if (world_file.generator_hash() != generator.config().hash())
+    {
+      SDL_Log("World '%s' was saved with other generator settings, not loading it", path.c_str());
+      world_file.close();
+      return false;
+    }
+
+  initialize_map(world_file.seed());
+  return true;
+}
+
+// Called on the main thread once the kinds of a chunk are in the map
+void Game::finish_chunk(int chunk_index)
+{
+  // Sprites on the border depend on the neighbor chunks, so the ring around the
+  // chunk is recomputed and those chunks redrawn as well
+  const int cx = chunk_index % CHUNK_COUNT;
+  const int cy = chunk_index / CHUNK_COUNT;
+  autotile_rect(tiles, {cx * CHUNK_SIZE - 1, cy * CHUNK_SIZE - 1, CHUNK_SIZE + 2, CHUNK_SIZE + 2});
+  terrain.invalidate();
+  sim.add_chunk(chunk_index);
+  fog.mark_chunk_dirty(chunk_index);
+  lod.mark_rect_dirty({cx * CHUNK_SIZE, cy * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE});
+
+  for (int y = std::max(0, cy - 1); y <= std::min(CHUNK_COUNT - 1, cy + 1); ++y)
+    {
+      for (int x = std::max(0, cx - 1); x <= std::min(CHUNK_COUNT - 1, cx + 1); ++x)
+        {
+          chunks.mark_chunk_dirty(y * CHUNK_COUNT + x);
+          paths.mark_cluster_dirty(y * CHUNK_COUNT + x);
+        }
+    }
+}
+
+void Game::stream_world(const SDL_Rect &visible)
+{
+  collect_generated();
+
+  const SDL_Rect range = ChunkCache::chunk_range(visible);
+  if (range.w <= 0 || range.h <= 0) return;
+
+  // Visible chunks are queued first, they show up as they finish
+  for (int cy = range.y; cy < range.y + range.h; ++cy)
+    {
+      for (int cx = range.x; cx < range.x + range.w; ++cx)
         {
-          tile.kind = TerrainKind::Grass;
+          request_chunk(cy * CHUNK_COUNT + cx);
         }
-      tile.selected = false;
+    }
+
+  // Chunks within the residency radius are prefetched a few at a time. Only
+  // that ring and the chunks holding a texture are visited, not the whole grid.
+  // Generated terrain (and any edit made to it) stays in the map planes (see
+  // MAP_SIZE), only textures are released.
+  const int x0 = std::max(0, range.x - residency_radius), x1 = std::min(CHUNK_COUNT, range.x + range.w + residency_radius);
+  const int y0 = std::max(0, range.y - residency_radius), y1 = std::min(CHUNK_COUNT, range.y + range.h + residency_radius);
+  int budget = PREFETCH_BUDGET;
 
-      // set_neighbors(tile);
+  for (int cy = y0; cy < y1 && budget > 0; ++cy)
+    {
+      for (int cx = x0; cx < x1 && budget > 0; ++cx)
+        {
+          const int index = cy * CHUNK_COUNT + cx;
+          if (generator.state(index) != ChunkState::Empty) continue;
+
+          request_chunk(index);
+          --budget;
+        }
     }
 
-  // Second pass: assign bitmask sprite now that all tiles have types
-  // for (auto &tile : tiles)
-  //   {
-  //     if (tile.kind == TerrainKind::Water)
-  //       {
-  //         tile.sprite = get_bitmask(tile);
-  //         // SDL_Log("sprite: {%f, %f, %f, %f}", tile.sprite.x, tile.sprite.y, tile.sprite.w, tile.sprite.h);
-  //       }
-  //     else
-  //       {
-  //         tile.sprite = {0, 0, TILE_SIZE, TILE_SIZE}; // fallback if needed
-  //       }
-  //   }
+  // Backwards, an eviction moves the last resident chunk into its slot
+  const std::vector<int> &resident = chunks.resident_chunks();
+  for (int i = static_cast<int>(resident.size()) - 1; i >= 0; --i)
+    {
+      const int cx = resident[i] % CHUNK_COUNT, cy = resident[i] / CHUNK_COUNT;
+      if (cx < x0 || cx >= x1 || cy < y0 || cy >= y1) chunks.evict(resident[i]);
+    }
 }
 
 SDL_FPoint Game::screen_to_world(SDL_FPoint screen_point) const
@@ -97,6 +225,35 @@ SDL_FPoint Game::screen_to_world(SDL_FPoint screen_point) const
   return {x+0.2f, y+0.2f};
 }
 
+// Range of tiles (in tile coordinates) covered by the window, clamped to the map
+SDL_Rect Game::visible_tiles() const
+{
+  int rw, rh;
+  SDL_GetCurrentRenderOutputSize(renderer, &rw, &rh);
+
+  const SDL_FPoint top_left = {(0 - viewport.x) / zoom, (0 - viewport.y) / zoom};
+  const SDL_FPoint bottom_right = {(rw - viewport.x) / zoom, (rh - viewport.y) / zoom};
+
+  const int x0 = std::max(0, static_cast<int>(SDL_floorf(top_left.x / TILE_SIZE)));
+  const int y0 = std::max(0, static_cast<int>(SDL_floorf(top_left.y / TILE_SIZE)));
+  const int x1 = std::min(MAP_SIZE, static_cast<int>(SDL_ceilf(bottom_right.x / TILE_SIZE)));
+  const int y1 = std::min(MAP_SIZE, static_cast<int>(SDL_ceilf(bottom_right.y / TILE_SIZE)));
+
+  if (x1 <= x0 || y1 <= y0) return {0, 0, 0, 0};
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+int Game::tile_at(SDL_FPoint world_point) const
+{
+  if (world_point.x < 0 || world_point.y < 0) return -1;
+
+  const int x = static_cast<int>(world_point.x) / TILE_SIZE;
+  const int y = static_cast<int>(world_point.y) / TILE_SIZE;
+  if (x >= MAP_SIZE || y >= MAP_SIZE) return -1;
+
+  return y * MAP_SIZE + x;
+}
+
 void Game::handle_mouse_wheel(int mouse_screen_x, int mouse_screen_y, float wheel_y)
 {
   float new_zoom;
@@ -105,7 +262,7 @@ void Game::handle_mouse_wheel(int mouse_screen_x, int mouse_screen_y, float whee
   if (wheel_y > 0)      new_zoom = zoom * zoom_step;
   else if (wheel_y < 0) new_zoom = zoom / zoom_step;
 
-  new_zoom = std::clamp(new_zoom, 0.5f, 4.0f);
+  new_zoom = std::clamp(new_zoom, MIN_ZOOM, MAX_ZOOM);
   if (new_zoom == zoom) return;
 
   // Compute current texture size on screen
@@ -126,6 +283,8 @@ void Game::handle_mouse_wheel(int mouse_screen_x, int mouse_screen_y, float whee
   // Adjust world position so the cursor points to the same content
   viewport.x = mouse_screen_x - rel_x * new_world_screen_w;
   viewport.y = mouse_screen_y - rel_y * new_world_screen_h;
+  // direct camera moves are not interpolated
+  prev_camera = {viewport.x, viewport.y};
 }
 
 void Game::handle_snapping(SDL_MouseMotionEvent &motion)
@@ -135,138 +294,834 @@ void Game::handle_snapping(SDL_MouseMotionEvent &motion)
 
   viewport.x += dx;
   viewport.y += dy;
+  prev_camera.x += dx;
+  prev_camera.y += dy;
 
   snap_offset.x = motion.x;
   snap_offset.y = motion.y;
 }
 
-SDL_AppResult Game::render()
+void Game::set_kind(int index, TerrainKind kind)
+{
+  if (tiles.kinds[index] == kind) return;
+
+  const TerrainKind previous = tiles.kinds[index];
+  tiles.kinds[index] = kind;
+  sim.set(index);
+  finish_tile(index, previous);
+}
+
+// Called once the kind of a tile changed in the map, by an edit or the terrain
+// simulation
+void Game::finish_tile(int index, TerrainKind previous)
+{
+  terrain.set(index, previous, tiles.kinds[index]);
+  if (TERRAIN_OPAQUE[previous] != TERRAIN_OPAQUE[tiles.kinds[index]]) fog.mark_dirty(index);
+  paths.mark_dirty(index);
+  lod.mark_dirty(index);
+  unsaved[ChunkCache::chunk_of(index)] = 1;
+  autotile_around(tiles, index);
+
+  // The neighbors' sprites may have changed too, and they can live in other chunks
+  const SDL_Point c = Tile{index}.coord();
+  for (int y = std::max(0, c.y - 1); y <= std::min(MAP_SIZE - 1, c.y + 1); ++y)
+    {
+      for (int x = std::max(0, c.x - 1); x <= std::min(MAP_SIZE - 1, c.x + 1); ++x)
+        {
+          chunks.mark_dirty(y * MAP_SIZE + x);
+        }
+    }
+}
+
+// Selection is drawn as an overlay, changing it never touches the chunk textures
+void Game::toggle_selected(int index)
+{
+  tiles.toggle_selected(index);
+  unsaved[ChunkCache::chunk_of(index)] = 1;
+}
+
+void Game::begin_selection(SDL_FPoint screen_point)
+{
+  selecting = true;
+  select_path.clear();
+  select_path.push_back(screen_to_world(screen_point));
+}
+
+void Game::extend_selection(SDL_FPoint screen_point)
 {
-  /* SDL_SetRenderDrawColor(renderer, DEFAULT_BACKGROUND_COLOR.r, DEFAULT_BACKGROUND_COLOR.g, DEFAULT_BACKGROUND_COLOR.b, DEFAULT_BACKGROUND_COLOR.a); */
-  /* SDL_RenderClear(renderer); */
+  if (!selecting) return;
 
-  SDL_SetRenderTarget(renderer, world_texture);
-  SDL_SetRenderScale(renderer, zoom, zoom);
+  const SDL_FPoint point = screen_to_world(screen_point);
+  if (select_mode == SELECT_BOX)
+    {
+      select_path.resize(1);
+      select_path.push_back(point);
+      return;
+    }
+
+  // The lasso only needs a few points per tile, motion events come much denser
+  const SDL_FPoint &last = select_path.back();
+  const float dx = point.x - last.x, dy = point.y - last.y;
+  if (dx * dx + dy * dy >= (TILE_SIZE / 4.0f) * (TILE_SIZE / 4.0f)) select_path.push_back(point);
+}
 
-  // @fixme: I think we could avoid this RenderClear since we will render in the entire texture anyway
-  SDL_SetRenderDrawColor(renderer, SDL_COLOR_RGBA(TERRAIN_COLORS[TerrainKind::Crust]));
-  // SDL_RenderTexture(renderer, bg, nullptr, &viewport);
-  SDL_RenderClear(renderer);
+void Game::end_selection(SelectOp op)
+{
+  if (!selecting) return;
+  selecting = false;
 
-  const SDL_FPoint point = screen_to_world(mouse_position);
+  const SDL_FPoint first = select_path.front(), last = select_path.back();
+  const int x0 = static_cast<int>(SDL_floorf(std::min(first.x, last.x) / TILE_SIZE));
+  const int y0 = static_cast<int>(SDL_floorf(std::min(first.y, last.y) / TILE_SIZE));
+  const int x1 = static_cast<int>(SDL_floorf(std::max(first.x, last.x) / TILE_SIZE));
+  const int y1 = static_cast<int>(SDL_floorf(std::max(first.y, last.y) / TILE_SIZE));
 
-  for (auto &tile : tiles)
+  // A click that stayed on one tile toggles it, like before drag selection
+  const bool lasso = select_mode == SELECT_LASSO && select_path.size() >= 3;
+  if (!lasso && x0 == x1 && y0 == y1)
     {
-      auto mouse_hover = SDL_PointInRectFloat(&point, &tile.rect);
-      if (mouse_hover) {
-        tile_on_mouse = &tile;
-      }
-      tile.render(renderer, tiles, mouse_hover, assets);
+      const int index = tile_at(last);
+      if (index >= 0) toggle_selected(index);
+      return;
     }
 
-  if (render_grid)
+  select_shape.clear();
+  if (lasso)
     {
-      SDL_SetRenderDrawColor(renderer, 0xfa, 0xfa, 0xfa, 0xff);
-      for (int i = 0; i < MAP_SIZE; i++)
+      for (auto &point : select_path)
+        {
+          point.x /= TILE_SIZE;
+          point.y /= TILE_SIZE;
+        }
+      select_shape.fill_polygon(select_path, scratch_arena);
+    }
+  else
+    {
+      select_shape.fill_rect({x0, y0, x1 - x0 + 1, y1 - y0 + 1});
+    }
+  select(select_shape, op);
+}
+
+void Game::select(const TileBits &shape, SelectOp op)
+{
+  PROFILE_ZONE("select");
+  select_before.words = tiles.selection.words;
+  apply_selection(tiles.selection, shape, op);
+  mark_selection_unsaved(select_before);
+}
+
+void Game::invert_selection()
+{
+  select_before.words = tiles.selection.words;
+  tiles.selection.invert();
+  mark_selection_unsaved(select_before);
+}
+
+// The selection is saved with the chunks, flag the ones it changed in
+void Game::mark_selection_unsaved(const TileBits &before)
+{
+  for (int i = 0; i < TileBits::WORDS; ++i)
+    {
+      uint64_t changed = before.words[i] ^ tiles.selection.words[i];
+      const int first = (i / TileBits::ROW_WORDS) * MAP_SIZE + (i % TileBits::ROW_WORDS) * 64;
+
+      // One lookup per chunk the word crosses, not per changed bit
+      while (changed)
         {
-          // render horizontal grid line
-          float x = 0.0f;
-          float y = static_cast<float>(i * TILE_SIZE);
-          SDL_RenderLine(renderer, x, y, MAP_SIZE * TILE_SIZE, y);
-
-          // render vertical grid line
-          x = static_cast<float>(i * TILE_SIZE);
-          y = 0;
-          SDL_RenderLine(renderer, x, y, x, MAP_SIZE * TILE_SIZE);
+          const int bit = std::countr_zero(changed);
+          unsaved[ChunkCache::chunk_of(first + bit)] = 1;
+          const int next = (bit / CHUNK_SIZE + 1) * CHUNK_SIZE;
+          changed = next >= 64 ? 0 : changed & (~uint64_t{0} << next);
         }
     }
+}
 
-  // 2. Reset Render Target to Window
-  SDL_SetRenderTarget(renderer, NULL);
+static SDL_Point tile_coord(SDL_FPoint world_point)
+{
+  return {static_cast<int>(SDL_floorf(world_point.x / TILE_SIZE)), static_cast<int>(SDL_floorf(world_point.y / TILE_SIZE))};
+}
 
-  // 3. Compose everything on the main renderer
-  SDL_SetRenderDrawColor(renderer, SDL_COLOR_RGBA(TERRAIN_COLORS[TerrainKind::Crust]));
-  SDL_RenderClear(renderer);
-    
-  SDL_RenderTexture(renderer, world_texture, NULL, &viewport);
+void Game::begin_stroke(SDL_FPoint screen_point)
+{
+  stroking = true;
+  stroke_start = stroke_last = tile_coord(screen_to_world(screen_point));
+  stroke_shape.clear();
+  if (brush != BRUSH_FILL) stroke_shape.fill_disc(stroke_start, brush_radius);
+}
+
+// Paint adds a line from the last point, the line brush only keeps the one
+// from where the stroke started
+void Game::extend_stroke(SDL_FPoint screen_point)
+{
+  if (!stroking || brush == BRUSH_FILL) return;
 
-  render_fps();
+  const SDL_Point tile = tile_coord(screen_to_world(screen_point));
+  if (tile.x == stroke_last.x && tile.y == stroke_last.y) return;
+
+  if (brush == BRUSH_LINE)
+    {
+      stroke_shape.clear();
+      stroke_shape.fill_line(stroke_start, tile, brush_radius);
+    }
+  else
+    {
+      stroke_shape.fill_line(stroke_last, tile, brush_radius);
+    }
+  stroke_last = tile;
+}
+
+void Game::end_stroke()
+{
+  if (!stroking) return;
+  stroking = false;
+
+  if (brush == BRUSH_FILL)
+    {
+      // The region the stroke started on, as the quadtree's uniform squares
+      const SDL_Point &start = stroke_start;
+      if (start.x < 0 || start.y < 0 || start.x >= MAP_SIZE || start.y >= MAP_SIZE) return;
+
+      fill_squares.clear();
+      terrain.flood_fill(start.y * MAP_SIZE + start.x, fill_squares);
+      for (const SDL_Rect &square : fill_squares) stroke_shape.fill_rect(square);
+    }
+  paint(stroke_shape, brush_kind);
+}
+
+// Every tile of `shape` becomes `kind`, as one undoable edit. Chunks that
+// aren't generated yet are left alone, generating them would overwrite it.
+void Game::paint(const TileBits &shape, TerrainKind kind)
+{
+  PROFILE_ZONE("paint");
+  history.begin();
+  for (int i = 0; i < TileBits::WORDS; ++i)
+    {
+      // Rows are whole words, so bit b of word i is tile i * 64 + b
+      for (uint64_t word = shape.words[i]; word; word &= word - 1)
+        {
+          const int index = i * 64 + std::countr_zero(word);
+          if (tiles.kinds[index] != kind && generator.is_generated(ChunkCache::chunk_of(index)))
+            {
+              history.record(index, tiles.kinds[index], kind);
+            }
+        }
+    }
+
+  if (const EditStroke *stroke = history.commit()) apply_edit(*stroke, true);
+}
+
+// Writes the kinds after (`redo`) or before a stroke. Tiles changed since, by
+// the terrain simulation, are overwritten too.
+void Game::apply_edit(const EditStroke &stroke, bool redo)
+{
+  PROFILE_ZONE("apply edit");
+  EditHistory::for_each_run(stroke, [&](int first, int count, TerrainKind before, TerrainKind after)
+    {
+      const TerrainKind kind = redo ? after : before;
+      for (int index = first; index < first + count; ++index)
+        {
+          const TerrainKind previous = tiles.kinds[index];
+          if (previous == kind) continue;
+
+          tiles.kinds[index] = kind;
+          sim.reset_tile(index);
+          if (TERRAIN_OPAQUE[previous] != TERRAIN_OPAQUE[kind]) fog.mark_dirty(index);
+          paths.mark_dirty(index);
+          unsaved[ChunkCache::chunk_of(index)] = 1;
+        }
+    });
+  sim.wake_area(stroke.bounds);
+  finish_area(stroke.bounds);
+}
+
+// What `finish_tile` does for one tile that doesn't depend on its kinds, once
+// for a whole area: sprites, the region queries and the drawn textures
+void Game::finish_area(const SDL_Rect &area)
+{
+  // Sprites around the area change too, and their chunks are redrawn
+  const SDL_Rect around = {area.x - 1, area.y - 1, area.w + 2, area.h + 2};
+  autotile_rect(tiles, around);
+  terrain.invalidate();
+  lod.mark_rect_dirty(area);
+
+  const int cx0 = std::max(0, around.x) / CHUNK_SIZE, cx1 = std::min(MAP_SIZE - 1, around.x + around.w - 1) / CHUNK_SIZE;
+  const int cy0 = std::max(0, around.y) / CHUNK_SIZE, cy1 = std::min(MAP_SIZE - 1, around.y + around.h - 1) / CHUNK_SIZE;
+  for (int y = cy0; y <= cy1; ++y)
+    {
+      for (int x = cx0; x <= cx1; ++x)
+        {
+          chunks.mark_chunk_dirty(y * CHUNK_COUNT + x);
+        }
+    }
+}
+
+void Game::undo_edit()
+{
+  if (const EditStroke *stroke = history.undo()) apply_edit(*stroke, false);
+}
+
+void Game::redo_edit()
+{
+  if (const EditStroke *stroke = history.redo()) apply_edit(*stroke, true);
+}
+
+// Start of a frame: the frame arena is emptied and every allocator's per frame
+// counters start over
+void Game::begin_frame()
+{
+  frame_arena.reset();
+  scratch_arena.end_frame();
+  history.end_frame();
+  chunks.end_frame();
+  heap_counter.end_frame();
+}
+
+// Run as many fixed updates as the frame time covers, the remainder is kept for
+// the next frame and used to interpolate what we draw
+void Game::advance(double frame_delta)
+{
+  accumulator += std::min(frame_delta, MAX_FRAME_DELTA);
+  while (accumulator >= SIM_TIMESTEP)
+    {
+      update(SIM_TIMESTEP);
+      accumulator -= SIM_TIMESTEP;
+    }
+  sim_alpha = accumulator / SIM_TIMESTEP;
+}
+
+// A recorded session starts over from a fresh map with the current seed and
+// camera, and replaying it starts from the same one
+bool Game::start_recording(const std::string &path)
+{
+  if (!journal.start_recording(path, generator.seed, {viewport.x, viewport.y}, zoom)) return false;
+
+  begin_session(generator.seed);
+  return true;
+}
+
+bool Game::start_replay(const std::string &path)
+{
+  if (!journal.start_replay(path)) return false;
+
+  const JournalHeader &header = journal.replay_header();
+  begin_session(header.seed);
+  viewport.x = header.camera_x;
+  viewport.y = header.camera_y;
+  zoom = header.zoom;
+  prev_camera = {viewport.x, viewport.y};
+  return true;
+}
+
+// Everything the input of a session acts on, back to a known state. The map
+// is generated whole before the first tick: streamed chunks arrive whenever
+// the workers finish them, which the journal can't reproduce, and units, the
+// terrain simulation and edits all depend on which chunks are in.
+void Game::begin_session(int seed)
+{
+  jobs.wait_idle();
+  world_file.close();
+  initialize_map(seed);
+  generate_all();
+
+  pan_left = pan_right = pan_up = pan_down = false;
+  snapping = selecting = stroking = false;
+  select_mode = SELECT_BOX;
+  brush = BRUSH_OFF;
+  brush_kind = Grass;
+  brush_radius = BRUSH_RADIUS;
+  simulate_terrain = true;
+  accumulator = 0;
+  sim_ticks = 0;
+}
+
+// Like `advance`, with the recorded input, so the session plays back in real
+// time. Returns false once the journal is done.
+bool Game::replay(double frame_delta)
+{
+  accumulator += std::min(frame_delta, MAX_FRAME_DELTA);
+  while (accumulator >= SIM_TIMESTEP)
+    {
+      if (!replay_tick()) return false;
+      accumulator -= SIM_TIMESTEP;
+    }
+  sim_alpha = accumulator / SIM_TIMESTEP;
+  return true;
+}
+
+// One fixed update with the input recorded before it, independent of the wall
+// clock. Returns false once the journal is done.
+bool Game::replay_tick()
+{
+  while (const JournalRecord *record = journal.next(sim_ticks))
+    {
+      SDL_Event event = InputJournal::to_event(*record);
+      SDL_SetModState(static_cast<SDL_Keymod>(record->mod));
+      if (handle_events(*this, &event) != SDL_APP_CONTINUE) return false;
+    }
+
+  update(SIM_TIMESTEP);
+  sim_alpha = 1.0;
+  return !journal.finished();
+}
+
+void Game::update(double dt)
+{
+  PROFILE_ZONE("update");
+  prev_camera = {viewport.x, viewport.y};
+
+  // Keyboard panning
+  const float step = static_cast<float>(PAN_SPEED * dt);
+  if (pan_left)  viewport.x += step;
+  if (pan_right) viewport.x -= step;
+  if (pan_up)    viewport.y += step;
+  if (pan_down)  viewport.y -= step;
+
+  {
+    PROFILE_ZONE("units");
+    units.update(static_cast<float>(dt), tiles);
+  }
+
+  if (simulate_terrain && sim_ticks % TERRAIN_SIM_INTERVAL == 0)
+    {
+      PROFILE_ZONE("terrain");
+      for (int index : sim.step(jobs))
+        {
+          finish_tile(index, sim.previous(index));
+        }
+    }
+
+  {
+    // Only viewers that changed tile, or near terrain that changed, recompute
+    PROFILE_ZONE("fog");
+    const int viewers = std::min(units.size(), FOG_VIEWERS);
+    fog.resize(viewers);
+    for (int i = 0; i < viewers; ++i)
+      {
+        fog.set_viewer(i, units.tile[i]);
+      }
+    fog.update();
+  }
+
+  ++sim_ticks;
+}
+
+// The profiler frame is begun and ended by the caller, around the input and
+// updates that go with it
+SDL_AppResult Game::render()
+{
+  Uint64 phase_start = SDL_GetPerformanceCounter();
+  auto end_phase = [&](FramePhase phase)
+  {
+    Uint64 now = SDL_GetPerformanceCounter();
+    phase_time[phase] = (now - phase_start) / frequency;
+    phase_start = now;
+  };
+
+  stats = {};
+
+  // Draw the camera where it is between the last two updates, the simulated
+  // position is put back once the frame is done
+  const SDL_FRect simulated = viewport;
+  viewport.x = prev_camera.x + (viewport.x - prev_camera.x) * static_cast<float>(sim_alpha);
+  viewport.y = prev_camera.y + (viewport.y - prev_camera.y) * static_cast<float>(sim_alpha);
+
+  const SDL_Rect visible = visible_tiles();
+
+  {
+    PROFILE_ZONE("stream");
+    // Chunks drawn before the tileset was in need to be drawn again
+    if (assets.upload(renderer, ASSET_UPLOAD_BUDGET) > 0) chunks.mark_all_dirty();
+    stream_world(visible);
+  }
+  end_phase(PHASE_STREAM);
+
+  // 1. Redraw only the visible chunks whose tiles changed since the last frame,
+  // zoomed far out the tiles are too small for them and the LOD map is used
+  const bool far = zoom < LOD_ZOOM;
+  {
+    PROFILE_ZONE("world render");
+    if (far) lod.update(renderer, tiles);
+    else     chunks.rebuild(renderer, tiles, visible, assets.get(grass_texture), stats);
+  }
+  end_phase(PHASE_REBUILD);
+
+  tile_on_mouse = tile_at(screen_to_world(mouse_position));
+  if (path_start >= 0)
+    {
+      PROFILE_ZONE("path");
+      path_cost = paths.find_path(path_start, tile_on_mouse, path_preview);
+    }
+
+  // 2. Compose the cached chunks on the main renderer
+  {
+    PROFILE_ZONE("compose");
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+    SDL_SetRenderDrawColor(renderer, SDL_COLOR_RGBA(TERRAIN_COLORS[TerrainKind::Crust]));
+    SDL_RenderClear(renderer);
+    stats.draw_calls += 1;
+
+    if (far) lod.draw(renderer, viewport, zoom, stats);
+    else     chunks.compose(renderer, viewport, zoom, visible, stats);
+  }
+  end_phase(PHASE_COMPOSE);
+
+  // 3. Things that change every frame are drawn on top in screen space
+  render_overlay(visible);
+  end_phase(PHASE_OVERLAY);
+  {
+    PROFILE_ZONE("text");
+    render_fps();
+  }
+  render_debug_ui();
+  end_phase(PHASE_TEXT);
     
   // Present the final rendered frame
-  SDL_RenderPresent(renderer);
+  {
+    PROFILE_ZONE("present");
+    SDL_RenderPresent(renderer);
+  }
+  last_stats = stats;
+  viewport = simulated;
+  end_phase(PHASE_PRESENT);
     
   return SDL_APP_CONTINUE;
 }
 
+void Game::render_overlay(const SDL_Rect &visible)
+{
+  const float size = TILE_SIZE * zoom;
+
+  render_selection(visible);
+  render_stroke(visible);
+  render_units(visible);
+  if (show_fog) render_fog(visible);
+
+  if (path_start >= 0 && path_cost >= 0)
+    {
+      // A dot in the middle of every tile of the path
+      const float dot = std::max(2.0f, size / 4);
+      for (int index : path_preview)
+        {
+          const SDL_FRect rect = Tile{index}.rect();
+          overlay_batch.push_rect({viewport.x + rect.x * zoom + (size - dot) / 2, viewport.y + rect.y * zoom + (size - dot) / 2, dot, dot},
+                                  {0xff, 0xd7, 0x00, SDL_ALPHA_OPAQUE});
+        }
+      overlay_batch.flush(renderer, stats);
+    }
+
+  if (tile_on_mouse >= 0)
+    {
+      SDL_Texture* tex = assets.get(frame_texture);
+      if (tex)
+        {
+          const SDL_FRect rect = Tile{tile_on_mouse}.rect();
+          SDL_FRect dst = {viewport.x + rect.x * zoom, viewport.y + rect.y * zoom, size, size};
+          SDL_RenderTexture(renderer, tex, nullptr, &dst);
+          stats.draw_calls += 1;
+        }
+    }
+
+  if (render_grid && visible.w > 0)
+    {
+      PROFILE_ZONE("grid");
+      const float left   = viewport.x + visible.x * size;
+      const float top    = viewport.y + visible.y * size;
+      const float right  = viewport.x + (visible.x + visible.w) * size;
+      const float bottom = viewport.y + (visible.y + visible.h) * size;
+
+      SDL_SetRenderDrawColor(renderer, 0xfa, 0xfa, 0xfa, 0xff);
+      // render horizontal grid lines
+      for (int i = visible.y; i <= visible.y + visible.h; i++)
+        {
+          float y = viewport.y + i * size;
+          SDL_RenderLine(renderer, left, y, right, y);
+          stats.draw_calls += 1;
+        }
+      // render vertical grid lines
+      for (int i = visible.x; i <= visible.x + visible.w; i++)
+        {
+          float x = viewport.x + i * size;
+          SDL_RenderLine(renderer, x, top, x, bottom);
+          stats.draw_calls += 1;
+        }
+    }
+}
+
+// Selected tiles are drawn as one quad per horizontal run, blended over the
+// terrain, followed by the outline of a drag in progress
+void Game::render_selection(const SDL_Rect &visible)
+{
+  PROFILE_ZONE("selection");
+  const float size = TILE_SIZE * zoom;
+
+  for (int y = visible.y; y < visible.y + visible.h; ++y)
+    {
+      tiles.selection.for_each_run(y, visible.x, visible.x + visible.w, [&](int x0, int x1)
+        {
+          overlay_batch.push_rect({viewport.x + x0 * size, viewport.y + y * size, (x1 - x0) * size, size}, {0xff, 0xff, 0xff, 0x60});
+        });
+    }
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  overlay_batch.flush(renderer, stats);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+  if (!selecting || select_path.size() < 2) return;
+
+  // Screen space points, closed for the lasso
+  const size_t count = select_path.size();
+  SDL_FPoint *outline = frame_arena.allocate_array<SDL_FPoint>(count + 1);
+  for (size_t i = 0; i < count; ++i)
+    {
+      outline[i] = {viewport.x + select_path[i].x * zoom, viewport.y + select_path[i].y * zoom};
+    }
+  outline[count] = outline[0];
+
+  SDL_SetRenderDrawColor(renderer, 0xfa, 0xfa, 0xfa, 0xff);
+  if (select_mode == SELECT_LASSO)
+    {
+      SDL_RenderLines(renderer, outline, static_cast<int>(count + 1));
+    }
+  else
+    {
+      const SDL_FPoint a = outline[0], b = outline[count - 1];
+      const SDL_FRect box = {std::min(a.x, b.x), std::min(a.y, b.y), SDL_fabsf(b.x - a.x), SDL_fabsf(b.y - a.y)};
+      SDL_RenderRect(renderer, &box);
+    }
+  stats.draw_calls += 1;
+}
+
+// The tiles of a stroke in progress, in the brush's kind
+void Game::render_stroke(const SDL_Rect &visible)
+{
+  if (!stroking || brush == BRUSH_FILL) return;
+
+  const float size = TILE_SIZE * zoom;
+  SDL_Color color = TERRAIN_COLORS[brush_kind];
+  color.a = 0xa0;
+  for (int y = visible.y; y < visible.y + visible.h; ++y)
+    {
+      stroke_shape.for_each_run(y, visible.x, visible.x + visible.w, [&](int x0, int x1)
+        {
+          overlay_batch.push_rect({viewport.x + x0 * size, viewport.y + y * size, (x1 - x0) * size, size}, color);
+        });
+    }
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  overlay_batch.flush(renderer, stats);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
+// Units are drawn where they are between the last two updates, like the camera.
+// Zoomed in, the tiles in view are walked through the spatial index, zoomed out
+// most units are visible anyway and a linear scan is cheaper.
+void Game::render_units(const SDL_Rect &visible)
+{
+  if (units.size() == 0 || visible.w <= 0) return;
+
+  PROFILE_ZONE("units");
+  const float alpha = static_cast<float>(sim_alpha);
+  const float size = std::max(1.0f, UNIT_SIZE * zoom);
+
+  auto draw = [&](int i)
+  {
+    const float x = units.px[i] + (units.x[i] - units.px[i]) * alpha;
+    const float y = units.py[i] + (units.y[i] - units.py[i]) * alpha;
+    overlay_batch.push_rect({viewport.x + x * zoom - size / 2, viewport.y + y * zoom - size / 2, size, size},
+                            UNIT_COLORS[units.sprite[i] % UNIT_COLOR_COUNT]);
+  };
+
+  if (visible.w * visible.h < units.size())
+    {
+      for (int y = visible.y; y < visible.y + visible.h; ++y)
+        {
+          for (int x = visible.x; x < visible.x + visible.w; ++x)
+            {
+              for (int i = units.first_in_tile(y * MAP_SIZE + x); i >= 0; i = units.next_in_tile(i)) draw(i);
+            }
+        }
+    }
+  else
+    {
+      const float left = static_cast<float>(visible.x * TILE_SIZE), right = static_cast<float>((visible.x + visible.w) * TILE_SIZE);
+      const float top = static_cast<float>(visible.y * TILE_SIZE), bottom = static_cast<float>((visible.y + visible.h) * TILE_SIZE);
+      for (int i = 0; i < units.size(); ++i)
+        {
+          if (units.x[i] < left || units.x[i] >= right || units.y[i] < top || units.y[i] >= bottom) continue;
+          draw(i);
+        }
+    }
+  overlay_batch.flush(renderer, stats);
+}
+
+// Fog over the tiles out of sight, one quad per horizontal run: opaque where
+// nothing was ever seen, dimmed where it was but isn't anymore
+void Game::render_fog(const SDL_Rect &visible)
+{
+  PROFILE_ZONE("fog");
+  const float size = TILE_SIZE * zoom;
+
+  for (int y = visible.y; y < visible.y + visible.h; ++y)
+    {
+      const float top = viewport.y + y * size;
+      fog.hidden.for_each_run(y, visible.x, visible.x + visible.w, [&](int x0, int x1)
+        {
+          overlay_batch.push_rect({viewport.x + x0 * size, top, (x1 - x0) * size, size}, {0x00, 0x00, 0x00, SDL_ALPHA_OPAQUE});
+        });
+      fog.remembered.for_each_run(y, visible.x, visible.x + visible.w, [&](int x0, int x1)
+        {
+          overlay_batch.push_rect({viewport.x + x0 * size, top, (x1 - x0) * size, size}, {0x00, 0x00, 0x00, 0x90});
+        });
+    }
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  overlay_batch.flush(renderer, stats);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
+// Units start in the middle of random passable tiles, heading anywhere
+void Game::spawn_units(int count, uint32_t seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> tile_dist(0, TILE_COUNT - 1);
+  std::uniform_real_distribution<float> angle_dist(0.0f, 2.0f * SDL_PI_F);
+  std::uniform_real_distribution<float> speed_dist(TILE_SIZE * 0.5f, TILE_SIZE * 3.0f);
+
+  for (int spawned = 0, tries = 0; spawned < count && tries < count * 16; ++tries)
+    {
+      const int index = tile_dist(rng);
+      if (!TERRAIN_COST[tiles.kinds[index]]) continue;
+
+      const SDL_FRect rect = Tile{index}.rect();
+      const float angle = angle_dist(rng), speed = speed_dist(rng);
+      units.spawn({rect.x + rect.w / 2, rect.y + rect.h / 2}, {SDL_cosf(angle) * speed, SDL_sinf(angle) * speed},
+                  static_cast<uint8_t>(rng() % UNIT_COLOR_COUNT));
+      ++spawned;
+    }
+}
+
+// ImGui is only set up by the interactive app, the headless paths skip it
+void Game::render_debug_ui()
+{
+  if (!ImGui::GetCurrentContext()) return;
+
+  PROFILE_ZONE("imgui");
+  ImGui_ImplSDLRenderer3_NewFrame();
+  ImGui_ImplSDL3_NewFrame();
+  ImGui::NewFrame();
+
+  if (show_profiler) profiler.draw_overlay(&show_profiler);
+  if (show_memory)
+    {
+      const AllocatorStats *allocators[] = {&frame_arena.stats(), &scratch_arena.stats(), &chunks.texture_stats(), &history.stats()};
+      draw_memory_overlay(allocators, SDL_arraysize(allocators), &show_memory);
+    }
+
+  ImGui::Render();
+  ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), renderer);
+}
+
 void Game::render_fps()
 {
-  static char buffer[128] = {0};
-  static Uint64 fps = 0;
-  static double elapsed = 0;
+  constexpr size_t BUFFER_SIZE = sizeof fps_text.string;
+  char *buffer = frame_arena.allocate_array<char>(BUFFER_SIZE);
     
   double frame_time = (curr_time - prev_time) / frequency;
-  elapsed += frame_time;
+  fps_elapsed += frame_time;
 
-  if (elapsed >= 2.0f)
+  if (fps_elapsed >= 2.0f)
     {
-      elapsed = 0;
+      fps_elapsed = 0;
       fps = (Uint32)(1 / frame_time);
+      jitter = pacer.stddev() * 1000.0;
     }
 
   int rw, rh;
   SDL_GetCurrentRenderOutputSize(renderer, &rw, &rh);
 
-  snprintf(buffer, sizeof buffer, "FFPS: %zu, tile: (%d, %d)", fps, tile_on_mouse->coord.x, tile_on_mouse->coord.y);
-  Text t = {0};
-  if (prepare_text(buffer, 12, WHITE, &t))
+  SDL_Point coord = tile_on_mouse >= 0 ? Tile{tile_on_mouse}.coord() : SDL_Point{-1, -1};
+  // @note: `quads` is what drawing one call per tile used to cost
+  int length = snprintf(buffer, BUFFER_SIZE, "FFPS: %zu, jitter: %.2fms, tile: (%d, %d), draws: %d (quads: %d, chunks: %d)",
+                        fps, jitter, coord.x, coord.y,
+                        last_stats.draw_calls, last_stats.quads, last_stats.chunks_rebuilt);
+  if (units.size() > 0 && length > 0 && length < (int)BUFFER_SIZE)
+    {
+      length += snprintf(buffer + length, BUFFER_SIZE - length, ", units: %d", units.size());
+    }
+  if (generator.pending_count() > 0 && length > 0 && length < (int)BUFFER_SIZE)
     {
-      t.rect.x = rw - t.rect.w - 10;
-      t.rect.y = rh - t.rect.h - 10;
-      render_text(&t);
-      destroy_text(&t);
+      snprintf(buffer + length, BUFFER_SIZE - length, ", generating: %d chunks", generator.pending_count());
+    }
+  if (prepare_text(buffer, 12, WHITE, &fps_text))
+    {
+      fps_text.rect.x = rw - fps_text.rect.w - 10;
+      fps_text.rect.y = rh - fps_text.rect.h - 10;
+      render_text(&fps_text);
     }
 }
   
+// Creates `output` on first use, afterwards the string, font size and color
+// are only pushed to SDL_ttf when they differ from what it already holds.
 bool Game::prepare_text(const char *text, float size, SDL_Color color, Text *output)
 {
-  TTF_SetFontSize(font, size);
+  if (!output->text || output->size != size)
+    {
+      TTF_Font *sized = text_engine.font(size);
+      if (!sized)
+        {
+          return false;
+        }
 
-  int w, h;
-  if (TTF_GetStringSize(font, text, 0, &w, &h))
+      if (!output->text)
+        {
+          output->text = TTF_CreateText(text_engine.engine, sized, text, 0);
+          if (!output->text)
+            {
+              SDL_Log("Couldn't prepare text SDL: %s\n", SDL_GetError());
+              return false;
+            }
+          SDL_strlcpy(output->string, text, sizeof output->string);
+        }
+      else
+        {
+          TTF_SetTextFont(output->text, sized);
+        }
+      output->size = size;
+      output->color = {0}; // force the color below
+    }
+
+  if (SDL_strcmp(output->string, text) != 0)
+    {
+      TTF_SetTextString(output->text, text, 0);
+      SDL_strlcpy(output->string, text, sizeof output->string);
+    }
+
+  if (SDL_memcmp(&output->color, &color, sizeof color) != 0)
     {
-      output->rect = SDL_FRect{.w = (float)w, .h = (float)h};
-      output->surface = TTF_RenderText_Blended(font, text, 0, color);
-      return true;
+      TTF_SetTextColor(output->text, SDL_COLOR_RGBA(color));
+      output->color = color;
     }
 
-  SDL_Log("Couldn't prepare text SDL: %s\n", SDL_GetError());
-  return false;
+  int w, h;
+  if (!TTF_GetTextSize(output->text, &w, &h))
+    {
+      SDL_Log("Couldn't prepare text SDL: %s\n", SDL_GetError());
+      return false;
+    }
+  output->rect.w = (float)w;
+  output->rect.h = (float)h;
+  return true;
 }
 
 void Game::destroy_text(Text *text)
 {
-  SDL_DestroySurface(text->surface);
+  if (text->text) TTF_DestroyText(text->text);
+  *text = {};
 }
 
 void Game::render_text(Text *text)
 {
-  if (text->surface)
+  if (text->text)
     {
-      auto texture = SDL_CreateTextureFromSurface(renderer, text->surface);
-      if (!texture)
-        {
-          SDL_Log("Couldn't create text: %s\n", SDL_GetError());
-        }
-      else
-        {
-          SDL_FRect dst;
-          SDL_GetTextureSize(texture, &dst.w, &dst.h);
-          dst.x = text->rect.x;
-          dst.y = text->rect.y;
-          SDL_RenderTexture(renderer, texture, NULL, &dst);
-          SDL_DestroyTexture(texture);
-        }
+      TTF_DrawRendererText(text->text, text->rect.x, text->rect.y);
+      stats.draw_calls += 1;
     }
 }
-
-
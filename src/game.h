@@ -15,12 +15,28 @@
 #include "asset.h"
 #include "tile.h"
 #include "tileset.h"
+#include "chunk.h"
+#include "generator.h"
+#include "jobs.h"
+#include "text.h"
+#include "profiler.h"
+#include "pacer.h"
+#include "save.h"
+#include "query.h"
+#include "path.h"
+#include "entity.h"
+#include "lod.h"
+#include "journal.h"
+#include "sim.h"
+#include "fov.h"
+#include "edit.h"
+#include "memory.h"
 
 class Game
 {
 public:  
   Game(SDL_Window *window, SDL_Renderer *renderer, TTF_Font *font)
-    : window(window), renderer(renderer), font(font), frequency((double)SDL_GetPerformanceFrequency())
+    : window(window), renderer(renderer), font(font), frequency((double)SDL_GetPerformanceFrequency()), pacer(TARGET_FRAME_TIME)
   {
   }
 
@@ -41,46 +57,166 @@ public:
   SDL_Renderer *renderer;
   TTF_Font *font;
   SDL_FPoint mouse_position = {0};
-  SDL_Texture *world_texture = nullptr;
   SDL_FRect viewport; // Where the world is drawn on screen
   
-  std::array<Tile, MAP_SIZE * MAP_SIZE> tiles;
+  TileMap tiles;
+  TerrainQuery terrain{tiles}; // region queries over `tiles`, declared after it
+  PathFinder paths{tiles};
+  TerrainSim sim{tiles};
+  FogOfWar fog{tiles}; // of the local player, its viewers are the first FOG_VIEWERS units
+  EntityStore units;
+  ChunkCache chunks;
+  LodMap lod; // replaces the chunks below LOD_ZOOM
+  JobSystem jobs;
+  TerrainGenerator generator;
+  int residency_radius = RESIDENCY_RADIUS;
+
+  WorldFile world_file; // save the chunks are loaded from, if any
+  std::vector<uint8_t> unsaved = std::vector<uint8_t>(CHUNK_COUNT * CHUNK_COUNT, 0); // per chunk
+  RenderStats stats, last_stats;
+
+  enum FramePhase
+  {
+    PHASE_STREAM,
+    PHASE_REBUILD,
+    PHASE_COMPOSE,
+    PHASE_OVERLAY,
+    PHASE_TEXT,
+    PHASE_PRESENT,
+    PHASE_COUNT,
+  };
+  static constexpr const char *PHASE_NAMES[PHASE_COUNT] = {"stream", "rebuild", "compose", "overlay", "text", "present"};
+  std::array<double, PHASE_COUNT> phase_time = {0}; // seconds spent in each phase by the last `render`
   
   // timer related variables
   Uint64 prev_time, curr_time;
   double delta_time, frequency;
+  FramePacer pacer;
+
+  // fixed timestep simulation
+  double accumulator = 0;
+  double sim_alpha = 0; // how far the frame is between the last two updates
+  Uint64 sim_ticks = 0;
+  SDL_FPoint prev_camera = {0}; // viewport position before the last update
   
   float zoom = 1.0f, prev_zoom = 1.0f; // Stores zoom from *before* the current frame/input
   
   SDL_FPoint snap_offset = {0};
   bool snapping = false;
+  // Arrow keys held, from the key events so replays reproduce them
+  bool pan_left = false, pan_right = false, pan_up = false, pan_down = false;
+
+  InputJournal journal;
   
+  bool simulate_terrain = true;
+  bool show_fog = false;
   bool render_grid = false;
-  // SDL_Texture *tileset_grass;
-  // @fixme: do not do this like this
-  SDL_Texture *grass;
-  SDL_Texture *frame;
-  SDL_Texture *solid_base_tile;
-  SDL_Texture *bg;
+  bool show_profiler = false;
+  bool show_memory = false;
+  TextureHandle bg_texture, grass_texture, frame_texture;
   
-  Tile *tile_on_mouse;
+  int tile_on_mouse = -1;
+
+  // Drag selection: a box between the first and last point of `select_path`,
+  // or a lasso through all of them. Points are in world space.
+  enum SelectMode { SELECT_BOX, SELECT_LASSO };
+  SelectMode select_mode = SELECT_BOX;
+  bool selecting = false;
+  std::vector<SDL_FPoint> select_path;
+  TileBits select_shape, select_before; // scratch, kept to avoid reallocating
+  TileBatch overlay_batch;
+
+  // Terrain brushes: while one is picked the left button paints `brush_kind`
+  // instead of selecting. A stroke collects its tiles in `stroke_shape` and
+  // changes the map once, when the button goes up, as one undoable edit.
+  enum BrushMode { BRUSH_OFF, BRUSH_PAINT, BRUSH_LINE, BRUSH_FILL, BRUSH_COUNT };
+  BrushMode brush = BRUSH_OFF;
+  TerrainKind brush_kind = Grass;
+  int brush_radius = BRUSH_RADIUS;
+  bool stroking = false;
+  SDL_Point stroke_start = {0}, stroke_last = {0}; // tiles
+  TileBits stroke_shape;
+  std::vector<SDL_Rect> fill_squares; // scratch, kept to avoid reallocating
+  EditHistory history;
+
+  // Path preview from `path_start` to the hovered tile, -1 when off
+  int path_start = -1;
+  int path_cost = -1;
+  std::vector<int> path_preview;
 
   Asset assets;
   
+  // Retained text: created once, re-laid out only when its string changes
   struct Text
   {
-    SDL_FRect rect;
-    SDL_Surface *surface;
+    TTF_Text *text = nullptr;
+    SDL_FRect rect = {0};
+    float size = 0;
+    SDL_Color color = {0};
+    char string[128] = {0}; // what `text` currently holds
   };
 
+  TextEngine text_engine;
+  Text fps_text;
+  Uint64 fps = 0;
+  double jitter = 0; // ms, sampled with `fps` so the HUD text stays put
+  double fps_elapsed = 0;
+
+  // Transient memory: the frame arena is emptied every frame, the scratch arena
+  // is for temporaries of any lifetime, given back with an `ArenaScope`
+  Arena frame_arena{"frame", FRAME_ARENA_SIZE};
+  Arena scratch_arena{"scratch", SCRATCH_ARENA_SIZE};
+
   bool create_world();
   SDL_FPoint screen_to_world(SDL_FPoint screen_point) const;
+  SDL_Rect visible_tiles() const;
+  int tile_at(SDL_FPoint world_point) const;
   void handle_mouse_wheel(int mouse_screen_x, int mouse_screen_y, float wheel_y);
   void handle_snapping(SDL_MouseMotionEvent &motion);
+  void set_kind(int index, TerrainKind kind);
+  void finish_tile(int index, TerrainKind previous);
+  void toggle_selected(int index);
+  void begin_selection(SDL_FPoint screen_point);
+  void extend_selection(SDL_FPoint screen_point);
+  void end_selection(SelectOp op);
+  void select(const TileBits &shape, SelectOp op);
+  void invert_selection();
+  void mark_selection_unsaved(const TileBits &before);
+  void begin_stroke(SDL_FPoint screen_point);
+  void extend_stroke(SDL_FPoint screen_point);
+  void end_stroke();
+  void paint(const TileBits &shape, TerrainKind kind);
+  void apply_edit(const EditStroke &stroke, bool redo);
+  void finish_area(const SDL_Rect &area);
+  void undo_edit();
+  void redo_edit();
   void render_fps();
+  void render_debug_ui();
   bool prepare_text(const char *text, float size, SDL_Color color, Text *output);
   void destroy_text(Text *text);
   void render_text(Text *text);
+  void begin_frame();
+  void advance(double frame_delta);
+  bool start_recording(const std::string &path);
+  bool start_replay(const std::string &path);
+  void begin_session(int seed);
+  bool replay(double frame_delta);
+  bool replay_tick();
+  void update(double dt);
   SDL_AppResult render();
+  void render_overlay(const SDL_Rect &visible);
+  void render_selection(const SDL_Rect &visible);
+  void render_stroke(const SDL_Rect &visible);
+  void render_units(const SDL_Rect &visible);
+  void render_fog(const SDL_Rect &visible);
+  void spawn_units(int count, uint32_t seed);
   void initialize_map(int noise_seed = 12237861);
+  bool load_generator(const std::string &path);
+  void generate_all();
+  void request_chunk(int chunk_index);
+  void collect_generated();
+  bool save_world(const std::string &path);
+  bool load_world(const std::string &path);
+  void finish_chunk(int chunk_index);
+  void stream_world(const SDL_Rect &visible);
 };
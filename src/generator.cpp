@@ -0,0 +1,427 @@
+#include "generator.h"
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; ++i)
+    {
+      hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+  return hash;
+}
+
+static bool parse_kind(const char *name, TerrainKind &kind)
+{
+  for (int k = 0; k < TERRAIN_KIND_COUNT; ++k)
+    {
+      if (SDL_strcasecmp(name, TERRAIN_NAMES[k]) == 0)
+        {
+          kind = static_cast<TerrainKind>(k);
+          return true;
+        }
+    }
+  return false;
+}
+
+// `key = value` lines, `#` starts a comment. Unknown keys are an error so a
+// typo doesn't silently fall back to a default.
+bool GeneratorConfig::load(const std::string &path)
+{
+  size_t size = 0;
+  char *data = static_cast<char *>(SDL_LoadFile(path.c_str(), &size));
+  if (!data)
+    {
+      SDL_Log("Failed to read %s: %s", path.c_str(), SDL_GetError());
+      return false;
+    }
+
+  GeneratorConfig config;
+  bool has_rules = false;
+  bool ok = true;
+  int line_number = 0;
+
+  for (char *line = data; line && ok; )
+    {
+      char *end = SDL_strchr(line, '\n');
+      if (end) *end = '\0';
+      ++line_number;
+
+      if (char *comment = SDL_strchr(line, '#')) *comment = '\0';
+
+      char key[32], value[512];
+      if (SDL_sscanf(line, " %31[a-z_] = %511[^\r]", key, value) == 2)
+        {
+          // Trailing blanks are part of %[^\r]
+          for (size_t n = SDL_strlen(value); n > 0 && (value[n - 1] == ' ' || value[n - 1] == '\t'); --n) value[n - 1] = '\0';
+
+          char kind_name[32];
+          GeneratorConfig::Rule rule;
+
+          if (SDL_strcmp(key, "source") == 0) config.source = value;
+          else if (SDL_strcmp(key, "octaves") == 0) ok = SDL_sscanf(value, "%d", &config.octaves) == 1;
+          else if (SDL_strcmp(key, "gain") == 0) ok = SDL_sscanf(value, "%f", &config.gain) == 1;
+          else if (SDL_strcmp(key, "lacunarity") == 0) ok = SDL_sscanf(value, "%f", &config.lacunarity) == 1;
+          else if (SDL_strcmp(key, "scale") == 0) ok = SDL_sscanf(value, "%f", &config.scale) == 1;
+          else if (SDL_strcmp(key, "encoded") == 0) config.encoded = value;
+          else if (SDL_strcmp(key, "moisture_scale") == 0) ok = SDL_sscanf(value, "%f", &config.moisture_scale) == 1;
+          else if (SDL_strcmp(key, "temperature_scale") == 0) ok = SDL_sscanf(value, "%f", &config.temperature_scale) == 1;
+          else if (SDL_strcmp(key, "absolute") == 0) config.absolute = SDL_atoi(value) != 0;
+          else if (SDL_strcmp(key, "fallback") == 0) ok = parse_kind(value, config.fallback);
+          else if (SDL_strcmp(key, "rule") == 0)
+            {
+              // Height range, then optionally moisture and temperature ranges.
+              // A field without a range doesn't restrict the rule.
+              for (int field = 0; field < FIELD_COUNT; ++field)
+                {
+                  rule.min[field] = -FLT_MAX;
+                  rule.max[field] = FLT_MAX;
+                }
+              const int count = SDL_sscanf(value, "%31s %f %f %f %f %f %f", kind_name,
+                                           &rule.min[FIELD_HEIGHT], &rule.max[FIELD_HEIGHT],
+                                           &rule.min[FIELD_MOISTURE], &rule.max[FIELD_MOISTURE],
+                                           &rule.min[FIELD_TEMPERATURE], &rule.max[FIELD_TEMPERATURE]);
+              ok = (count == 3 || count == 5 || count == 7) && parse_kind(kind_name, rule.kind);
+              if (ok)
+                {
+                  // The file's rules replace the default ones
+                  if (!has_rules) config.rules.clear();
+                  has_rules = true;
+                  config.rules.push_back(rule);
+                }
+            }
+          else ok = false;
+        }
+      else
+        {
+          // Only blank lines may not be `key = value`
+          for (const char *c = line; *c && ok; ++c) ok = *c == ' ' || *c == '\t' || *c == '\r';
+        }
+
+      line = end ? end + 1 : nullptr;
+    }
+  SDL_free(data);
+
+  if (!ok)
+    {
+      SDL_Log("%s:%d: invalid line", path.c_str(), line_number);
+      return false;
+    }
+
+  *this = config;
+  return true;
+}
+
+uint64_t GeneratorConfig::field_hash(int field) const
+{
+  // The field is part of the hash so that equal parameters of different
+  // fields don't share cache entries
+  uint64_t hash = fnv1a(0xcbf29ce484222325ull, &field, sizeof field);
+  if (field == FIELD_MOISTURE) return fnv1a(hash, &moisture_scale, sizeof moisture_scale);
+  if (field == FIELD_TEMPERATURE) return fnv1a(hash, &temperature_scale, sizeof temperature_scale);
+
+  if (!encoded.empty()) return fnv1a(hash, encoded.data(), encoded.size());
+
+  hash = fnv1a(hash, source.data(), source.size());
+  hash = fnv1a(hash, &octaves, sizeof octaves);
+  if (octaves > 1)
+    {
+      hash = fnv1a(hash, &gain, sizeof gain);
+      hash = fnv1a(hash, &lacunarity, sizeof lacunarity);
+    }
+  return fnv1a(hash, &scale, sizeof scale);
+}
+
+uint64_t GeneratorConfig::hash() const
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (int field = 0; field < FIELD_COUNT; ++field)
+    {
+      const uint64_t field_value = field_hash(field);
+      hash = fnv1a(hash, &field_value, sizeof field_value);
+    }
+
+  // Member by member, a Rule has padding
+  hash = fnv1a(hash, &absolute, sizeof absolute);
+  hash = fnv1a(hash, &fallback, sizeof fallback);
+  for (const Rule &rule : rules)
+    {
+      hash = fnv1a(hash, &rule.kind, sizeof rule.kind);
+      hash = fnv1a(hash, rule.min, sizeof rule.min);
+      hash = fnv1a(hash, rule.max, sizeof rule.max);
+    }
+  return hash;
+}
+
+static FastNoise::SmartNode<> scaled_simplex(float scale)
+{
+  auto node = FastNoise::New<FastNoise::DomainScale>();
+  node->SetSource(FastNoise::New<FastNoise::Simplex>());
+  node->SetScale(scale);
+  return node;
+}
+
+TerrainGenerator::TerrainGenerator()
+{
+  configure(GeneratorConfig{});
+}
+
+bool TerrainGenerator::configure(const GeneratorConfig &config)
+{
+  FastNoise::SmartNode<> root;
+
+  if (!config.encoded.empty())
+    {
+      root = FastNoise::NewFromEncodedNodeTree(config.encoded.c_str());
+      if (!root)
+        {
+          SDL_Log("Invalid encoded node tree");
+          return false;
+        }
+    }
+  else
+    {
+      FastNoise::SmartNode<> source;
+      if (config.source == "simplex")           source = FastNoise::New<FastNoise::Simplex>();
+      else if (config.source == "opensimplex2") source = FastNoise::New<FastNoise::OpenSimplex2>();
+      else if (config.source == "perlin")       source = FastNoise::New<FastNoise::Perlin>();
+      else if (config.source == "value")        source = FastNoise::New<FastNoise::Value>();
+      else
+        {
+          SDL_Log("Unknown noise source '%s'", config.source.c_str());
+          return false;
+        }
+
+      if (config.octaves > 1)
+        {
+          auto fractal = FastNoise::New<FastNoise::FractalFBm>();
+          fractal->SetSource(source);
+          fractal->SetOctaveCount(config.octaves);
+          fractal->SetGain(config.gain);
+          fractal->SetLacunarity(config.lacunarity);
+          source = fractal;
+        }
+
+      auto scale = FastNoise::New<FastNoise::DomainScale>();
+      scale->SetSource(source);
+      scale->SetScale(config.scale);
+      root = scale;
+    }
+
+  fields[FIELD_HEIGHT] = root;
+  fields[FIELD_MOISTURE] = scaled_simplex(config.moisture_scale);
+  fields[FIELD_TEMPERATURE] = scaled_simplex(config.temperature_scale);
+  current = config;
+  for (int field = 0; field < FIELD_COUNT; ++field) field_hashes[field] = config.field_hash(field);
+  build_biome_table();
+  return true;
+}
+
+void TerrainGenerator::build_biome_table()
+{
+  // Noise is in [-1, 1], |height| in [0, 1]
+  for (int field = 0; field < FIELD_COUNT; ++field)
+    {
+      const bool absolute = field == FIELD_HEIGHT && current.absolute;
+      field_low[field] = absolute ? 0.0f : -1.0f;
+      field_scale[field] = BIOME_LEVELS[field] / (absolute ? 1.0f : 2.0f);
+    }
+
+  // A field no rule restricts is never sampled, its level stays 0
+  field_used[FIELD_HEIGHT] = true;
+  field_used[FIELD_MOISTURE] = field_used[FIELD_TEMPERATURE] = false;
+  for (const auto &rule : current.rules)
+    {
+      for (int field = FIELD_MOISTURE; field < FIELD_COUNT; ++field)
+        {
+          if (rule.min[field] > -FLT_MAX || rule.max[field] < FLT_MAX) field_used[field] = true;
+        }
+    }
+
+  // Every cell gets the kind of the value at its center, thresholds are only
+  // as precise as BIOME_LEVELS
+  int index = 0;
+  for (int h = 0; h < BIOME_LEVELS[FIELD_HEIGHT]; ++h)
+    for (int m = 0; m < BIOME_LEVELS[FIELD_MOISTURE]; ++m)
+      for (int t = 0; t < BIOME_LEVELS[FIELD_TEMPERATURE]; ++t)
+        {
+          const int levels[FIELD_COUNT] = {h, m, t};
+          float values[FIELD_COUNT];
+          for (int field = 0; field < FIELD_COUNT; ++field)
+            {
+              values[field] = field_low[field] + (levels[field] + 0.5f) / field_scale[field];
+            }
+
+          TerrainKind kind = current.fallback;
+          for (const auto &rule : current.rules)
+            {
+              bool inside = true;
+              for (int field = 0; field < FIELD_COUNT; ++field)
+                {
+                  inside = inside && values[field] >= rule.min[field] && values[field] <= rule.max[field];
+                }
+              if (inside)
+                {
+                  kind = rule.kind;
+                  break;
+                }
+            }
+          biome_table[index++] = kind;
+        }
+}
+
+void TerrainGenerator::reset(JobSystem &jobs, TileMap &tiles, int noise_seed)
+{
+  jobs.wait_idle();
+  collect_finished(tiles);
+
+  seed = noise_seed;
+  std::fill(states.begin(), states.end(), ChunkState::Empty);
+  ready_count = 0;
+  pending = 0;
+}
+
+void TerrainGenerator::mark_ready(int chunk_index)
+{
+  if (states[chunk_index] == ChunkState::Ready) return;
+  if (states[chunk_index] == ChunkState::Pending) --pending;
+
+  states[chunk_index] = ChunkState::Ready;
+  ++ready_count;
+}
+
+void TerrainGenerator::request(JobSystem &jobs, int chunk_index)
+{
+  if (states[chunk_index] != ChunkState::Empty) return;
+
+  states[chunk_index] = ChunkState::Pending;
+  ++pending;
+
+  jobs.submit([this, chunk_index]()
+    {
+      Finished result;
+      result.chunk_index = chunk_index;
+      generate_chunk(result.kinds, chunk_index);
+
+      std::lock_guard lock(finished_mutex);
+      finished.push_back(result);
+    });
+}
+
+const std::vector<int> &TerrainGenerator::collect_finished(TileMap &tiles)
+{
+  swap.clear();
+  {
+    std::lock_guard lock(finished_mutex);
+    std::swap(swap, finished);
+  }
+
+  collected.clear();
+  for (const auto &result : swap)
+    {
+      const int cx = result.chunk_index % CHUNK_COUNT;
+      const int cy = result.chunk_index / CHUNK_COUNT;
+      for (int y = 0; y < CHUNK_SIZE; ++y)
+        {
+          std::copy_n(&result.kinds[y * CHUNK_SIZE], CHUNK_SIZE,
+                      &tiles.kinds[(cy * CHUNK_SIZE + y) * MAP_SIZE + cx * CHUNK_SIZE]);
+        }
+
+      states[result.chunk_index] = ChunkState::Ready;
+      ++ready_count;
+      --pending;
+      collected.push_back(result.chunk_index);
+    }
+  return collected;
+}
+
+bool TerrainGenerator::cached_noise(const CacheKey &key, ChunkNoise &noise) const
+{
+  std::lock_guard lock(cache_mutex);
+  auto it = cache.find(key);
+  if (it == cache.end()) return false;
+
+  cache_ages.splice(cache_ages.begin(), cache_ages, it->second.age);
+  noise = it->second.noise;
+  return true;
+}
+
+void TerrainGenerator::cache_noise(const CacheKey &key, const ChunkNoise &noise) const
+{
+  std::lock_guard lock(cache_mutex);
+  // Two jobs may have sampled the same chunk, the first one is kept
+  if (cache.count(key)) return;
+
+  if (static_cast<int>(cache.size()) >= GENERATION_CACHE_CHUNKS)
+    {
+      cache.erase(cache_ages.back());
+      cache_ages.pop_back();
+    }
+  cache_ages.push_front(key);
+  cache.emplace(key, CacheEntry{noise, cache_ages.begin()});
+}
+
+void TerrainGenerator::classify(const FieldNoise &noise, ChunkKinds &kinds) const
+{
+  constexpr int N = CHUNK_SIZE * CHUNK_SIZE;
+
+  // Each field adds level * stride to the table index of every tile. The loops
+  // are straight float and int arithmetic, no branches, so they vectorize.
+  std::array<int, N> index = {0};
+  int stride = 1;
+  for (int field = FIELD_COUNT - 1; field >= 0; --field)
+    {
+      if (field_used[field])
+        {
+          const float *values = noise[field].data();
+          const float low = field_low[field];
+          const float scale = field_scale[field];
+          const int top = BIOME_LEVELS[field] - 1;
+          if (field == FIELD_HEIGHT && current.absolute)
+            {
+              for (int i = 0; i < N; ++i)
+                {
+                  const int level = static_cast<int>((SDL_fabsf(values[i]) - low) * scale);
+                  index[i] += std::min(std::max(level, 0), top) * stride;
+                }
+            }
+          else
+            {
+              for (int i = 0; i < N; ++i)
+                {
+                  const int level = static_cast<int>((values[i] - low) * scale);
+                  index[i] += std::min(std::max(level, 0), top) * stride;
+                }
+            }
+        }
+      stride *= BIOME_LEVELS[field];
+    }
+
+  for (int i = 0; i < N; ++i) kinds[i] = biome_table[index[i]];
+}
+
+void TerrainGenerator::sample_field(int field, int chunk_index, ChunkNoise &noise) const
+{
+  const CacheKey key = {field_hashes[field], seed, chunk_index};
+  if (cached_noise(key, noise))
+    {
+      hits.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+  // Each field gets its own seed, they would all be the same noise otherwise
+  const int cx = chunk_index % CHUNK_COUNT;
+  const int cy = chunk_index / CHUNK_COUNT;
+  fields[field]->GenUniformGrid2D(noise.data(), cx * CHUNK_SIZE, cy * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, 1.0f, seed + field);
+  cache_noise(key, noise);
+  misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TerrainGenerator::generate_chunk(ChunkKinds &kinds, int chunk_index) const
+{
+  FieldNoise noise;
+  for (int field = 0; field < FIELD_COUNT; ++field)
+    {
+      if (field_used[field]) sample_field(field, chunk_index, noise[field]);
+    }
+  classify(noise, kinds);
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <cfloat>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <FastNoise/FastNoise.h>
+
+#include "config.h"
+#include "tile.h"
+#include "jobs.h"
+
+enum NoiseField
+{
+  FIELD_HEIGHT,
+  FIELD_MOISTURE,
+  FIELD_TEMPERATURE,
+  FIELD_COUNT,
+};
+
+// What the generator runs, normally loaded from GENERATOR_CONFIG_PATH (see the
+// comments there for the format). The defaults are the original hardcoded
+// Simplex -> DomainScale(0.2) graph with |height| <= 0.2 as Crust.
+struct GeneratorConfig
+{
+  // Height graph
+  std::string source = "simplex"; // simplex, opensimplex2, perlin or value
+  int octaves = 1;                // more than one wraps the source in an FBm fractal
+  float gain = 0.5f;
+  float lacunarity = 2.0f;
+  float scale = 0.2f;
+  std::string encoded;            // FastNoise2 encoded node tree, replaces the above
+
+  // Simplex noise at these scales, only sampled when a rule looks at them
+  float moisture_scale = 0.05f;
+  float temperature_scale = 0.03f;
+
+  // Classification: the first rule whose ranges hold all three fields wins
+  struct Rule
+  {
+    TerrainKind kind;
+    float min[FIELD_COUNT], max[FIELD_COUNT];
+  };
+  bool absolute = true; // classify |height| instead of height
+  std::vector<Rule> rules = {{TerrainKind::Crust, {0.0f, -FLT_MAX, -FLT_MAX}, {0.2f, FLT_MAX, FLT_MAX}}};
+  TerrainKind fallback = TerrainKind::Grass;
+
+  bool load(const std::string &path);
+  // Identifies the noise a field produces, classification not included
+  uint64_t field_hash(int field) const;
+  // Identifies the terrain the config generates: every field and the rules
+  uint64_t hash() const;
+};
+
+// Levels each field is quantized to for the biome table, height gets the most
+// since most rules split on it
+inline constexpr int BIOME_LEVELS[FIELD_COUNT] = {128, 16, 16};
+inline constexpr int BIOME_TABLE_SIZE = BIOME_LEVELS[0] * BIOME_LEVELS[1] * BIOME_LEVELS[2];
+
+enum class ChunkState : uint8_t
+{
+  Empty,
+  Pending, // a job is generating it
+  Ready,
+};
+
+// Generates the terrain one chunk at a time, on demand, from the noise graph.
+// Noise is sampled at the chunk's world offset, so a chunk always comes out the
+// same for a given seed no matter in which order chunks are generated.
+//
+// Chunks are generated by jobs on the worker pool into their own buffers. The
+// map and the chunk states are only touched from the main thread, when the
+// results are picked up by `collect_finished`.
+//
+// A chunk samples a height field and, when the rules use them, moisture and
+// temperature fields. Classification doesn't walk the rules: every field is
+// quantized to BIOME_LEVELS and the levels index a table, built from the rules
+// by `configure`, that holds the kind of every combination. Its cost is the
+// same for any number of rules.
+//
+// The raw noise of every chunk and field is cached by (field hash, seed,
+// chunk), least recently used out first. Changing only the classification, or
+// one field's parameters, only samples what changed.
+class TerrainGenerator
+{
+public:
+  TerrainGenerator();
+
+  // Build the noise graphs and the biome table for `config`. No chunk may be
+  // generating.
+  bool configure(const GeneratorConfig &config);
+  const GeneratorConfig &config() const { return current; }
+
+  // Forget every generated chunk, they will be regenerated with the new seed.
+  // Waits for the jobs in flight first.
+  void reset(JobSystem &jobs, TileMap &tiles, int noise_seed);
+
+  ChunkState state(int chunk_index) const { return states[chunk_index]; }
+  bool is_generated(int chunk_index) const { return states[chunk_index] == ChunkState::Ready; }
+  int generated_count() const { return ready_count; }
+  int pending_count() const { return pending; }
+
+  using ChunkKinds = std::array<TerrainKind, CHUNK_SIZE * CHUNK_SIZE>;
+
+  // For chunks filled by other means, e.g. loaded from a save
+  void mark_ready(int chunk_index);
+  // Queue the generation of a chunk if it was never requested
+  void request(JobSystem &jobs, int chunk_index);
+  // Copy the chunks whose job finished since the last call into the map, they
+  // are now Ready. Returns their indices, sprites are left to the caller.
+  const std::vector<int> &collect_finished(TileMap &tiles);
+
+  // Generate one chunk, row major. Thread safe.
+  void generate_chunk(ChunkKinds &kinds, int chunk_index) const;
+
+  int seed = 0;
+
+  int cache_hits() const { return hits.load(std::memory_order_relaxed); }
+  int cache_misses() const { return misses.load(std::memory_order_relaxed); }
+
+private:
+  using ChunkNoise = std::array<float, CHUNK_SIZE * CHUNK_SIZE>;
+  using FieldNoise = std::array<ChunkNoise, FIELD_COUNT>;
+
+  struct CacheKey
+  {
+    uint64_t field;
+    int seed;
+    int chunk_index;
+    bool operator==(const CacheKey &other) const = default;
+  };
+  struct CacheKeyHash
+  {
+    size_t operator()(const CacheKey &key) const
+    {
+      return static_cast<size_t>(key.field ^ (uint64_t(uint32_t(key.seed)) * 0x9e3779b97f4a7c15ull) ^ (uint64_t(key.chunk_index) << 32));
+    }
+  };
+  struct CacheEntry
+  {
+    ChunkNoise noise;
+    std::list<CacheKey>::iterator age;
+  };
+
+  void sample_field(int field, int chunk_index, ChunkNoise &noise) const;
+  bool cached_noise(const CacheKey &key, ChunkNoise &noise) const;
+  void cache_noise(const CacheKey &key, const ChunkNoise &noise) const;
+  void build_biome_table();
+  void classify(const FieldNoise &noise, ChunkKinds &kinds) const;
+
+  GeneratorConfig current;
+  std::array<FastNoise::SmartNode<>, FIELD_COUNT> fields;
+  std::array<uint64_t, FIELD_COUNT> field_hashes = {0};
+  std::array<bool, FIELD_COUNT> field_used = {true, false, false};
+  // Field value -> level is (value - low) * scale, clamped
+  std::array<float, FIELD_COUNT> field_low = {0}, field_scale = {0};
+  std::vector<TerrainKind> biome_table = std::vector<TerrainKind>(BIOME_TABLE_SIZE, TerrainKind::Crust);
+
+  // Shared by the generation jobs
+  mutable std::mutex cache_mutex;
+  mutable std::unordered_map<CacheKey, CacheEntry, CacheKeyHash> cache;
+  mutable std::list<CacheKey> cache_ages; // most recently used first
+  mutable std::atomic<int> hits{0}, misses{0};
+
+  std::vector<ChunkState> states = std::vector<ChunkState>(CHUNK_COUNT * CHUNK_COUNT, ChunkState::Empty);
+  int ready_count = 0;
+  int pending = 0;
+
+  struct Finished
+  {
+    int chunk_index;
+    ChunkKinds kinds;
+  };
+
+  std::mutex finished_mutex;
+  std::vector<Finished> finished, swap;
+  std::vector<int> collected;
+};
@@ -0,0 +1,158 @@
+#include "jobs.h"
+
+static thread_local int worker_index = -1;
+
+void JobSystem::start(int worker_count)
+{
+  if (running) return;
+  running = true;
+
+  for (int i = 0; i < worker_count; ++i)
+    {
+      queues.push_back(std::make_unique<Queue>());
+    }
+  for (int i = 0; i < worker_count; ++i)
+    {
+      workers.emplace_back(&JobSystem::worker_loop, this, i);
+    }
+}
+
+void JobSystem::stop()
+{
+  if (!running) return;
+
+  {
+    std::lock_guard lock(sleep_mutex);
+    running = false;
+  }
+  wake.notify_all();
+
+  for (auto &worker : workers) worker.join();
+  workers.clear();
+  queues.clear();
+}
+
+void JobSystem::submit(Job job, JobGroup *group)
+{
+  pending_count.fetch_add(1, std::memory_order_acq_rel);
+  if (group) group->pending.fetch_add(1, std::memory_order_acq_rel);
+
+  Task task = {std::move(job), group};
+  if (queues.empty())
+    {
+      // No workers, e.g. the pool was never started: run inline
+      run(task);
+      return;
+    }
+
+  const int index = worker_index >= 0 ? worker_index : static_cast<int>(next_queue++ % queues.size());
+  {
+    std::lock_guard lock(queues[index]->mutex);
+    queues[index]->jobs.push_back(std::move(task));
+  }
+
+  // Sleeping workers check `queued` under the same lock, so the job can't be
+  // counted between their check and their wait
+  {
+    std::lock_guard lock(sleep_mutex);
+    queued.fetch_add(1, std::memory_order_release);
+  }
+  wake.notify_one();
+}
+
+bool JobSystem::try_pop(int index, Task &task, const JobGroup *group)
+{
+  const int count = static_cast<int>(queues.size());
+  if (count == 0) return false;
+
+  // Own queue first, newest job (its data is likely still in cache)
+  if (index >= 0)
+    {
+      auto &own = *queues[index];
+      std::lock_guard lock(own.mutex);
+      for (auto it = own.jobs.rbegin(); it != own.jobs.rend(); ++it)
+        {
+          if (group && it->group != group) continue;
+          task = std::move(*it);
+          own.jobs.erase(std::next(it).base());
+          queued.fetch_sub(1, std::memory_order_acq_rel);
+          return true;
+        }
+    }
+
+  // Then steal the oldest job of somebody else
+  const int start = index >= 0 ? index + 1 : 0;
+  for (int i = 0; i < count; ++i)
+    {
+      auto &victim = *queues[(start + i) % count];
+      std::lock_guard lock(victim.mutex);
+      for (auto it = victim.jobs.begin(); it != victim.jobs.end(); ++it)
+        {
+          if (group && it->group != group) continue;
+          task = std::move(*it);
+          victim.jobs.erase(it);
+          queued.fetch_sub(1, std::memory_order_acq_rel);
+          return true;
+        }
+    }
+
+  return false;
+}
+
+void JobSystem::run(Task &task)
+{
+  task.job();
+  if (task.group) task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+  pending_count.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::worker_loop(int index)
+{
+  worker_index = index;
+
+  while (true)
+    {
+      Task task;
+      if (try_pop(index, task))
+        {
+          run(task);
+          continue;
+        }
+
+      std::unique_lock lock(sleep_mutex);
+      wake.wait(lock, [this] { return !running || queued.load(std::memory_order_acquire) > 0; });
+      if (!running) break;
+    }
+}
+
+void JobSystem::wait_idle()
+{
+  Task task;
+  while (pending() > 0)
+    {
+      if (try_pop(worker_index, task))
+        {
+          run(task);
+        }
+      else
+        {
+          std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::wait(JobGroup &group)
+{
+  Task task;
+  while (group.pending.load(std::memory_order_acquire) > 0)
+    {
+      if (try_pop(worker_index, task, &group))
+        {
+          run(task);
+        }
+      else
+        {
+          std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Jobs submitted together, so their submitter can wait for them alone
+struct JobGroup
+{
+  std::atomic<int> pending{0};
+};
+
+// Fixed pool of worker threads. Every worker owns a queue: it runs its own jobs
+// newest first and steals the oldest jobs of the other workers when it runs out.
+class JobSystem
+{
+public:
+  using Job = std::function<void()>;
+
+  ~JobSystem() { stop(); }
+
+  void start(int worker_count);
+  void stop();
+
+  // Thread safe, jobs submitted from a worker go to that worker's queue
+  void submit(Job job, JobGroup *group = nullptr);
+  // Run jobs on the calling thread until none is left
+  void wait_idle();
+  // Run the group's jobs on the calling thread until all of them are done,
+  // other jobs (chunk generation, texture loads) are left to the workers
+  void wait(JobGroup &group);
+
+  int pending() const { return pending_count.load(std::memory_order_acquire); }
+  int worker_count() const { return static_cast<int>(workers.size()); }
+
+private:
+  struct Task
+  {
+    Job job;
+    JobGroup *group = nullptr;
+  };
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> jobs;
+  };
+
+  void worker_loop(int index);
+  // Any job when `group` is null, otherwise one of that group only
+  bool try_pop(int index, Task &task, const JobGroup *group = nullptr);
+  void run(Task &task);
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+
+  std::atomic<int> pending_count{0};
+  std::atomic<int> queued{0}; // jobs in the queues, raised under `sleep_mutex`
+  std::atomic<bool> running{false};
+  std::atomic<unsigned> next_queue{0};
+};
@@ -0,0 +1,175 @@
+#include "journal.h"
+
+// Records are written in batches, the file only sees a write every few seconds
+static constexpr size_t FLUSH_RECORDS = 512;
+
+bool InputJournal::start_recording(const std::string &path, int seed, SDL_FPoint camera, float zoom)
+{
+  stop_recording();
+
+  io = SDL_IOFromFile(path.c_str(), "wb");
+  if (!io)
+    {
+      SDL_Log("Failed to create journal %s: %s", path.c_str(), SDL_GetError());
+      return false;
+    }
+
+  const JournalHeader h = {JOURNAL_MAGIC, JOURNAL_VERSION, 0, MAP_SIZE, seed, camera.x, camera.y, zoom, 0};
+  if (SDL_WriteIO(io, &h, sizeof h) != sizeof h)
+    {
+      SDL_Log("Failed to write journal %s: %s", path.c_str(), SDL_GetError());
+      SDL_CloseIO(io);
+      io = nullptr;
+      return false;
+    }
+  return true;
+}
+
+void InputJournal::record(const SDL_Event &event, Uint64 tick)
+{
+  if (!io) return;
+
+  JournalRecord r = {};
+  r.tick = static_cast<Uint32>(tick);
+  r.mod = SDL_GetModState();
+
+  switch (event.type)
+    {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+      r.type = event.type == SDL_EVENT_KEY_DOWN ? JOURNAL_KEY_DOWN : JOURNAL_KEY_UP;
+      r.key = static_cast<Sint32>(event.key.key);
+      r.mod = event.key.mod;
+      r.button = event.key.repeat;
+      break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+      r.type = event.type == SDL_EVENT_MOUSE_BUTTON_DOWN ? JOURNAL_BUTTON_DOWN : JOURNAL_BUTTON_UP;
+      r.button = event.button.button;
+      r.x = event.button.x;
+      r.y = event.button.y;
+      break;
+    case SDL_EVENT_MOUSE_MOTION:
+      r.type = JOURNAL_MOTION;
+      r.x = event.motion.x;
+      r.y = event.motion.y;
+      break;
+    case SDL_EVENT_MOUSE_WHEEL:
+      r.type = JOURNAL_WHEEL;
+      r.button = static_cast<Uint8>(event.wheel.direction);
+      r.key = event.wheel.integer_y;
+      r.x = event.wheel.mouse_x;
+      r.y = event.wheel.mouse_y;
+      r.value = event.wheel.y;
+      break;
+    default:
+      return;
+    }
+
+  pending.push_back(r);
+  if (pending.size() >= FLUSH_RECORDS) flush();
+}
+
+void InputJournal::flush()
+{
+  if (!io || pending.empty()) return;
+
+  const size_t bytes = pending.size() * sizeof(JournalRecord);
+  if (SDL_WriteIO(io, pending.data(), bytes) != bytes)
+    {
+      SDL_Log("Failed to write journal: %s", SDL_GetError());
+    }
+  pending.clear();
+}
+
+void InputJournal::stop_recording()
+{
+  if (!io) return;
+
+  flush();
+  SDL_CloseIO(io);
+  io = nullptr;
+}
+
+bool InputJournal::start_replay(const std::string &path)
+{
+  replaying = false;
+  records.clear();
+  cursor = 0;
+
+  size_t size = 0;
+  void *data = SDL_LoadFile(path.c_str(), &size);
+  if (!data)
+    {
+      SDL_Log("Failed to read journal %s: %s", path.c_str(), SDL_GetError());
+      return false;
+    }
+
+  bool ok = size >= sizeof(JournalHeader);
+  if (ok)
+    {
+      SDL_memcpy(&header, data, sizeof header);
+      ok = header.magic == JOURNAL_MAGIC && header.version == JOURNAL_VERSION && header.map_size == MAP_SIZE;
+    }
+  if (!ok)
+    {
+      SDL_Log("%s is not a journal for this build (map size %d)", path.c_str(), MAP_SIZE);
+      SDL_free(data);
+      return false;
+    }
+
+  // A partial record at the end (the recording was cut short) is dropped
+  const size_t count = (size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+  records.resize(count);
+  SDL_memcpy(records.data(), static_cast<Uint8 *>(data) + sizeof(JournalHeader), count * sizeof(JournalRecord));
+  SDL_free(data);
+
+  replaying = true;
+  return true;
+}
+
+const JournalRecord *InputJournal::next(Uint64 tick)
+{
+  if (cursor >= records.size() || records[cursor].tick > tick) return nullptr;
+  return &records[cursor++];
+}
+
+SDL_Event InputJournal::to_event(const JournalRecord &r)
+{
+  SDL_Event event;
+  SDL_zero(event);
+
+  switch (r.type)
+    {
+    case JOURNAL_KEY_DOWN:
+    case JOURNAL_KEY_UP:
+      event.type = r.type == JOURNAL_KEY_DOWN ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+      event.key.key = static_cast<SDL_Keycode>(r.key);
+      event.key.mod = r.mod;
+      event.key.down = r.type == JOURNAL_KEY_DOWN;
+      event.key.repeat = r.button != 0;
+      break;
+    case JOURNAL_BUTTON_DOWN:
+    case JOURNAL_BUTTON_UP:
+      event.type = r.type == JOURNAL_BUTTON_DOWN ? SDL_EVENT_MOUSE_BUTTON_DOWN : SDL_EVENT_MOUSE_BUTTON_UP;
+      event.button.button = r.button;
+      event.button.down = r.type == JOURNAL_BUTTON_DOWN;
+      event.button.x = r.x;
+      event.button.y = r.y;
+      break;
+    case JOURNAL_MOTION:
+      event.type = SDL_EVENT_MOUSE_MOTION;
+      event.motion.x = r.x;
+      event.motion.y = r.y;
+      break;
+    case JOURNAL_WHEEL:
+      event.type = SDL_EVENT_MOUSE_WHEEL;
+      event.wheel.direction = static_cast<SDL_MouseWheelDirection>(r.button);
+      event.wheel.integer_y = r.key;
+      event.wheel.mouse_x = r.x;
+      event.wheel.mouse_y = r.y;
+      event.wheel.y = r.value;
+      break;
+    }
+  return event;
+}
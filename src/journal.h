@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+
+// Input journal, all integers little endian:
+//
+//   JournalHeader
+//   JournalRecord[]   until the end of the file, in tick order
+//
+// Records are the input events `handle_events` acts on, stamped with the
+// simulation tick they arrived before. Replaying runs one fixed update per tick
+// and feeds each tick's records through `handle_events` first, without a
+// window if need be.
+//
+// Both ends start from `Game::begin_session`, which generates the whole map
+// before the first tick so nothing depends on when worker jobs finish. The
+// generator config isn't recorded: the replay follows the session as long as
+// terrain.cfg is the same file (F6 reloads it mid-session too).
+inline constexpr Uint32 JOURNAL_MAGIC = 0x4e4a5054; // "TPJN"
+inline constexpr Uint16 JOURNAL_VERSION = 1;
+
+struct JournalHeader
+{
+  Uint32 magic;
+  Uint16 version;
+  Uint16 reserved;
+  Uint32 map_size;
+  Sint32 seed;
+  float camera_x, camera_y, zoom;
+  Uint32 reserved2;
+};
+
+enum JournalType : Uint8
+{
+  JOURNAL_KEY_DOWN,
+  JOURNAL_KEY_UP,
+  JOURNAL_BUTTON_DOWN,
+  JOURNAL_BUTTON_UP,
+  JOURNAL_MOTION,
+  JOURNAL_WHEEL,
+};
+
+struct JournalRecord
+{
+  Uint32 tick;
+  Uint8 type;    // JournalType
+  Uint8 button;  // mouse button, key repeat or wheel direction
+  Uint16 mod;    // modifier state when it happened
+  Sint32 key;    // keycode, or the wheel's integer steps
+  float x, y;    // mouse position
+  float value;   // wheel amount
+};
+
+static_assert(sizeof(JournalHeader) == 32 && sizeof(JournalRecord) == 24, "on-disk layout");
+
+class InputJournal
+{
+public:
+  ~InputJournal() { stop_recording(); }
+
+  bool start_recording(const std::string &path, int seed, SDL_FPoint camera, float zoom);
+  // Events that don't affect the game are ignored
+  void record(const SDL_Event &event, Uint64 tick);
+  void stop_recording();
+  bool is_recording() const { return io != nullptr; }
+
+  bool start_replay(const std::string &path);
+  // The next record due at or before `tick`, null when there's none yet
+  const JournalRecord *next(Uint64 tick);
+  bool is_replaying() const { return replaying; }
+  bool finished() const { return cursor >= records.size(); }
+  void stop_replay() { replaying = false; }
+
+  const JournalHeader &replay_header() const { return header; }
+  static SDL_Event to_event(const JournalRecord &record);
+
+private:
+  void flush();
+
+  SDL_IOStream *io = nullptr;
+  std::vector<JournalRecord> pending; // recorded, not written yet
+
+  JournalHeader header = {};
+  std::vector<JournalRecord> records;
+  size_t cursor = 0;
+  bool replaying = false;
+};
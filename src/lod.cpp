@@ -0,0 +1,83 @@
+#include "lod.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+void LodMap::destroy()
+{
+  if (texture) SDL_DestroyTexture(texture);
+  texture = nullptr;
+  mark_all_dirty();
+}
+
+void LodMap::mark_rect_dirty(const SDL_Rect &area)
+{
+  if (dirty.w <= 0 || dirty.h <= 0)
+    {
+      dirty = area;
+    }
+  else
+    {
+      SDL_GetRectUnion(&dirty, &area, &dirty);
+    }
+
+  const SDL_Rect map = {0, 0, MAP_SIZE, MAP_SIZE};
+  if (!SDL_GetRectIntersection(&dirty, &map, &dirty)) dirty = {0, 0, 0, 0};
+}
+
+bool LodMap::update(SDL_Renderer *renderer, const TileMap &tiles)
+{
+  if (!texture)
+    {
+      texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, MAP_SIZE, MAP_SIZE);
+      if (!texture)
+        {
+          SDL_Log("Failed to create LOD texture: %s", SDL_GetError());
+          return false;
+        }
+      SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+
+      const SDL_PixelFormatDetails *format = SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_RGBA8888);
+      for (int kind = 0; kind < TERRAIN_KIND_COUNT; ++kind)
+        {
+          palette[kind] = SDL_MapRGBA(format, nullptr, SDL_COLOR_RGBA(TERRAIN_COLORS[kind]));
+        }
+      mark_all_dirty();
+    }
+
+  if (dirty.w <= 0 || dirty.h <= 0) return true;
+
+  PROFILE_ZONE("lod upload");
+  void *pixels;
+  int pitch;
+  if (!SDL_LockTexture(texture, &dirty, &pixels, &pitch))
+    {
+      SDL_Log("Failed to lock LOD texture: %s", SDL_GetError());
+      return false;
+    }
+
+  for (int y = 0; y < dirty.h; ++y)
+    {
+      Uint32 *row = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(pixels) + y * pitch);
+      const TerrainKind *kinds = &tiles.kinds[(dirty.y + y) * MAP_SIZE + dirty.x];
+      for (int x = 0; x < dirty.w; ++x)
+        {
+          row[x] = palette[kinds[x]];
+        }
+    }
+  SDL_UnlockTexture(texture);
+
+  dirty = {0, 0, 0, 0};
+  return true;
+}
+
+void LodMap::draw(SDL_Renderer *renderer, const SDL_FRect &viewport, float zoom, RenderStats &stats) const
+{
+  if (!texture) return;
+
+  const float size = static_cast<float>(MAP_SIZE * TILE_SIZE) * zoom;
+  const SDL_FRect dst = {viewport.x, viewport.y, size, size};
+  SDL_RenderTexture(renderer, texture, nullptr, &dst);
+  stats.draw_calls += 1;
+  stats.quads += 1;
+}
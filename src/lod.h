@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+#include "batch.h"
+
+// Far zoom levels draw the map from a streaming texture with one texel per
+// tile, colored by kind, instead of the chunk textures: one draw call and
+// MAP_SIZE^2 texels however much of the map is in view. Changes are tracked as
+// a dirty rectangle and only that part of the texture is locked and refilled.
+class LodMap
+{
+public:
+  void destroy();
+
+  void mark_dirty(int tile_index) { mark_rect_dirty({tile_index % MAP_SIZE, tile_index / MAP_SIZE, 1, 1}); }
+  void mark_rect_dirty(const SDL_Rect &area);
+  void mark_all_dirty() { dirty = {0, 0, MAP_SIZE, MAP_SIZE}; }
+
+  // Create the texture on first use and upload the dirty texels
+  bool update(SDL_Renderer *renderer, const TileMap &tiles);
+  void draw(SDL_Renderer *renderer, const SDL_FRect &viewport, float zoom, RenderStats &stats) const;
+
+private:
+  SDL_Texture *texture = nullptr;
+  Uint32 palette[TERRAIN_KIND_COUNT] = {0}; // TERRAIN_COLORS in the texture format
+  SDL_Rect dirty = {0, 0, MAP_SIZE, MAP_SIZE};
+};
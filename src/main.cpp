@@ -5,6 +5,10 @@
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
+#include <imgui.h>
+#include <backends/imgui_impl_sdl3.h>
+#include <backends/imgui_impl_sdlrenderer3.h>
+
 #include "game.h"
 #include "events.h"
 
@@ -36,12 +40,11 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
   SDL_SetWindowResizable(window, false);
   SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
 
-  // @todo: put it in a configuration
-  // if (SDL_SetRenderVSync(renderer, 1) == false)
-  //   {
-  //     SDL_Log("Could not enable VSync! SDL error: %s\n", SDL_GetError());
-  //     return SDL_APP_FAILURE;
-  //   }
+  if (VSYNC && SDL_SetRenderVSync(renderer, 1) == false)
+    {
+      SDL_Log("Could not enable VSync! SDL error: %s\n", SDL_GetError());
+      return SDL_APP_FAILURE;
+    }
   
   //SDL_SetRenderLogicalPresentation(renderer, logical_width, logical_height, SDL_LOGICAL_PRESENTATION_LETTERBOX);
   
@@ -59,6 +62,12 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
       return SDL_APP_FAILURE;
     }
 
+  IMGUI_CHECKVERSION();
+  ImGui::CreateContext();
+  ImGui::GetIO().IniFilename = nullptr;
+  ImGui_ImplSDL3_InitForSDLRenderer(window, renderer);
+  ImGui_ImplSDLRenderer3_Init(renderer);
+
   Game *game = new Game(window, renderer, font);
   
   if (!game->create_world()) return SDL_APP_FAILURE;
@@ -66,7 +75,19 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
   // initialize_terrain_mask();
   game->initialize_map();
 
+  // --record <journal> captures the session's input, --replay <journal> plays
+  // one back at the fixed timestep
+  for (int i = 1; i + 1 < argc; ++i)
+    {
+      if (SDL_strcmp(argv[i], "--record") == 0 && !game->start_recording(argv[i + 1])) return SDL_APP_FAILURE;
+      if (SDL_strcmp(argv[i], "--replay") == 0 && !game->start_replay(argv[i + 1])) return SDL_APP_FAILURE;
+    }
+
   *appstate = game;
+
+  // Profiler frames run from the end of one iteration to the end of the next,
+  // so the events SDL delivers in between and the fixed updates are in them
+  PROFILE_FRAME_BEGIN();
   
   // Initialize SDL, create window/renderer, load assets
   // Set up *appstate if you want to avoid global variables
@@ -78,6 +99,8 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
   Game *game = static_cast<Game *>(appstate);
   if (game)
     {
+      // Live input would make the replay diverge
+      if (game->journal.is_replaying() && event->type != SDL_EVENT_QUIT) return SDL_APP_CONTINUE;
       return handle_events(*game, event);
     }
 
@@ -88,18 +111,28 @@ SDL_AppResult SDL_AppIterate(void *appstate)
 {
   Game *game = static_cast<Game *>(appstate);
   
+  game->pacer.frame_start();
+  game->begin_frame();
   game->prev_time = game->curr_time;
   game->curr_time = SDL_GetPerformanceCounter();
-  game->delta_time = (double)(game->prev_time - game->curr_time) / game->frequency;
+  game->delta_time = (double)(game->curr_time - game->prev_time) / game->frequency;
+
+  if (game->journal.is_replaying())
+    {
+      if (!game->replay(game->delta_time)) return SDL_APP_SUCCESS;
+    }
+  else
+    {
+      game->advance(game->delta_time);
+    }
   
   auto result = game->render();
+  PROFILE_FRAME_END();
   if (result != SDL_APP_CONTINUE) return result;
 
-  double frame_time = (double)(SDL_GetPerformanceCounter() - game->curr_time) / game->frequency;
-  // SDL_Log("frame took %fms", frame_time); 
-  if (frame_time < TARGET_FRAME_TIME) {
-    SDL_Delay((Uint32)((TARGET_FRAME_TIME - frame_time) * 1000.0));
-  }
+  // With VSync the present already waits for the display
+  if (!VSYNC) game->pacer.wait();
+  PROFILE_FRAME_BEGIN();
 
   return SDL_APP_CONTINUE;
 }
@@ -110,6 +143,13 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result)
 
   if (game)
     {
+      game->journal.stop_recording();
+      game->jobs.stop();
+      game->destroy_text(&game->fps_text);
+      game->text_engine.destroy();
+      ImGui_ImplSDLRenderer3_Shutdown();
+      ImGui_ImplSDL3_Shutdown();
+      ImGui::DestroyContext();
       TTF_CloseFont(game->font);
       SDL_DestroyRenderer(game->renderer);
       SDL_DestroyWindow(game->window);
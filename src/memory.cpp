@@ -0,0 +1,154 @@
+#include "memory.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <imgui.h>
+
+// Overflow allocations start with the link to the previous one
+static constexpr size_t OVERFLOW_HEADER = alignof(std::max_align_t);
+
+Arena::Arena(const char *name, size_t capacity)
+{
+  counters.name = name;
+  counters.capacity = capacity;
+  block = static_cast<uint8_t *>(SDL_malloc(capacity));
+}
+
+Arena::~Arena()
+{
+  reset();
+  SDL_free(block);
+}
+
+void *Arena::allocate(size_t size, size_t align)
+{
+  SDL_assert(align <= OVERFLOW_HEADER && (align & (align - 1)) == 0);
+  ++counters.allocations;
+
+  const size_t start = (offset + align - 1) & ~(align - 1);
+  if (block && start + size <= counters.capacity)
+    {
+      offset = start + size;
+      counters.used = offset;
+      counters.peak = std::max(counters.peak, offset + overflow_bytes);
+      return block + start;
+    }
+
+  // Doesn't fit, the block is grown at the next reset
+  uint8_t *memory = static_cast<uint8_t *>(SDL_malloc(OVERFLOW_HEADER + size));
+  if (!memory)
+    {
+      SDL_Log("Arena '%s' out of memory", counters.name);
+      return nullptr;
+    }
+  *reinterpret_cast<void **>(memory) = overflow;
+  overflow = memory;
+  overflow_bytes += size;
+  ++counters.misses;
+  counters.peak = std::max(counters.peak, offset + overflow_bytes);
+  return memory + OVERFLOW_HEADER;
+}
+
+void Arena::reset()
+{
+  while (overflow)
+    {
+      void *previous = *static_cast<void **>(overflow);
+      SDL_free(overflow);
+      overflow = previous;
+    }
+
+  if (counters.peak > counters.capacity)
+    {
+      SDL_free(block);
+      counters.capacity = counters.peak;
+      block = static_cast<uint8_t *>(SDL_malloc(counters.capacity));
+    }
+
+  offset = 0;
+  overflow_bytes = 0;
+  counters.used = 0;
+  end_frame();
+}
+
+void Arena::end_frame()
+{
+  counters.last_allocations = counters.allocations;
+  counters.allocations = 0;
+}
+
+HeapCounter heap_counter;
+
+static std::atomic<int> heap_allocations{0};
+
+void HeapCounter::end_frame()
+{
+  last_frame = heap_allocations.exchange(0, std::memory_order_relaxed);
+}
+
+#ifdef GAME_PROFILE
+// Replacing these also covers the array and nothrow forms, which call them
+void *operator new(std::size_t size)
+{
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size ? size : 1)) return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+#endif
+
+void draw_memory_overlay(const AllocatorStats *const *stats, int count, bool *open)
+{
+  if (!ImGui::Begin("Memory", open))
+    {
+      ImGui::End();
+      return;
+    }
+
+#ifdef GAME_PROFILE
+  ImGui::Text("heap allocations last frame: %d", heap_counter.last_frame);
+#else
+  ImGui::TextUnformatted("heap allocations aren't counted in release builds");
+#endif
+
+  if (ImGui::BeginTable("allocators", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+      ImGui::TableSetupColumn("allocator");
+      ImGui::TableSetupColumn("used");
+      ImGui::TableSetupColumn("peak");
+      ImGui::TableSetupColumn("capacity");
+      ImGui::TableSetupColumn("allocs/frame");
+      ImGui::TableSetupColumn("misses");
+      ImGui::TableHeadersRow();
+      for (int i = 0; i < count; ++i)
+        {
+          const AllocatorStats &s = *stats[i];
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(s.name);
+          ImGui::TableNextColumn();
+          ImGui::Text("%zu", s.used);
+          ImGui::TableNextColumn();
+          ImGui::Text("%zu", s.peak);
+          ImGui::TableNextColumn();
+          ImGui::Text("%zu", s.capacity);
+          ImGui::TableNextColumn();
+          ImGui::Text("%d", s.last_allocations);
+          ImGui::TableNextColumn();
+          ImGui::Text("%d", s.misses);
+        }
+      ImGui::EndTable();
+    }
+  ImGui::End();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <SDL3/SDL.h>
+
+// Counters kept by every allocator below, shown by `draw_memory_overlay`.
+// Arenas count bytes, pools count objects.
+struct AllocatorStats
+{
+  const char *name = "";
+  size_t capacity = 0;
+  size_t used = 0, peak = 0;
+  int allocations = 0;      // since the frame started
+  int last_allocations = 0; // during the last frame
+  int misses = 0;           // total of arena overflows or empty pool acquires
+};
+
+// Linear allocator over one block: allocating bumps an offset and nothing is
+// freed on its own, `reset` or `rewind` drops everything after a point at
+// once. For trivially destructible data only, destructors never run.
+//
+// An allocation that doesn't fit comes from the heap and is freed by the next
+// `reset`, which also grows the block to the peak seen so far. After a few
+// frames the steady state doesn't touch the heap. Not thread safe.
+class Arena
+{
+public:
+  Arena(const char *name, size_t capacity);
+  ~Arena();
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+  template <typename T>
+  T *allocate_array(size_t count)
+  {
+    static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destroyed");
+    return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  size_t mark() const { return offset; }
+  // Drop what was allocated since `mark`, overflow blocks stay until `reset`
+  void rewind(size_t marker) { offset = marker; }
+  // Drop everything, also ends the frame for the statistics
+  void reset();
+  // Ends the frame for the statistics of an arena that isn't reset every frame
+  void end_frame();
+
+  const AllocatorStats &stats() const { return counters; }
+
+private:
+  uint8_t *block = nullptr;
+  size_t offset = 0;
+  size_t overflow_bytes = 0;
+  void *overflow = nullptr; // heap allocations chained through their first word
+  AllocatorStats counters;
+};
+
+// Rewinds an arena to where it was when the scope started
+struct ArenaScope
+{
+  Arena &arena;
+  size_t marker;
+  explicit ArenaScope(Arena &arena) : arena(arena), marker(arena.mark()) {}
+  ~ArenaScope() { arena.rewind(marker); }
+};
+
+// A fixed number of spare objects kept for reuse instead of being destroyed
+// and created again, e.g. textures of chunks going in and out of view.
+// `acquire` hands out a spare if there is one, `release` keeps an object if
+// there is room. The caller creates and destroys the objects otherwise.
+template <typename T, int N>
+class Pool
+{
+public:
+  explicit Pool(const char *name) { counters.name = name; counters.capacity = N; }
+
+  bool acquire(T &out)
+  {
+    ++counters.allocations;
+    if (count == 0)
+      {
+        ++counters.misses;
+        return false;
+      }
+    out = spares[--count];
+    counters.used = count;
+    return true;
+  }
+
+  bool release(const T &object)
+  {
+    if (count == N) return false;
+    spares[count++] = object;
+    counters.used = count;
+    counters.peak = std::max(counters.peak, counters.used);
+    return true;
+  }
+
+  // Hands out every spare left, to be destroyed
+  template <typename Destroy>
+  void drain(Destroy &&destroy)
+  {
+    while (count > 0) destroy(spares[--count]);
+    counters.used = 0;
+  }
+
+  void end_frame()
+  {
+    counters.last_allocations = counters.allocations;
+    counters.allocations = 0;
+  }
+
+  const AllocatorStats &stats() const { return counters; }
+
+private:
+  std::array<T, N> spares;
+  int count = 0;
+  AllocatorStats counters;
+};
+
+// Heap allocations through operator new (SDL and ImGui use their own
+// allocators) on any thread, counted in builds with GAME_PROFILE only.
+struct HeapCounter
+{
+  int last_frame = 0;
+  void end_frame();
+};
+
+extern HeapCounter heap_counter;
+
+// ImGui window with the statistics of `stats`
+void draw_memory_overlay(const AllocatorStats *const *stats, int count, bool *open);
@@ -0,0 +1,65 @@
+#include "pacer.h"
+
+#include <cmath>
+
+FramePacer::FramePacer(double target_frame_time)
+  : target(target_frame_time), frequency((double)SDL_GetPerformanceFrequency())
+{
+}
+
+void FramePacer::frame_start()
+{
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (last_start != 0)
+    {
+      intervals[next] = (now - last_start) / frequency;
+      next = (next + 1) % INTERVALS;
+      if (count < INTERVALS) ++count;
+    }
+  last_start = now;
+}
+
+void FramePacer::wait()
+{
+  const Uint64 period = static_cast<Uint64>(target * frequency);
+  const Uint64 now = SDL_GetPerformanceCounter();
+
+  // Deadlines advance by exactly one period so rounding does not drift, unless
+  // we fell behind: then start over from now instead of rushing to catch up
+  deadline += period;
+  if (deadline <= now || deadline > now + period)
+    {
+      deadline = now + period;
+    }
+
+  const Uint64 spin = static_cast<Uint64>(spin_threshold * frequency);
+  const Uint64 remaining = deadline - now;
+  if (remaining > spin)
+    {
+      SDL_DelayNS(static_cast<Uint64>((remaining - spin) / frequency * SDL_NS_PER_SECOND));
+    }
+
+  while (SDL_GetPerformanceCounter() < deadline)
+    {
+      SDL_CPUPauseInstruction();
+    }
+}
+
+double FramePacer::mean() const
+{
+  if (count == 0) return 0;
+
+  double sum = 0;
+  for (int i = 0; i < count; ++i) sum += intervals[i];
+  return sum / count;
+}
+
+double FramePacer::stddev() const
+{
+  if (count < 2) return 0;
+
+  const double m = mean();
+  double sum = 0;
+  for (int i = 0; i < count; ++i) sum += (intervals[i] - m) * (intervals[i] - m);
+  return std::sqrt(sum / (count - 1));
+}
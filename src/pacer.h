@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+
+#include <SDL3/SDL.h>
+
+// Keeps frames on a fixed schedule. The OS sleep is only accurate to about a
+// millisecond, so we sleep until `spin_threshold` before the deadline and
+// busy-wait the rest. Frame intervals are recorded to measure the jitter.
+class FramePacer
+{
+public:
+  explicit FramePacer(double target_frame_time);
+
+  // Call at the start of every frame, records the interval since the last one
+  void frame_start();
+  // Block until the next frame is due
+  void wait();
+
+  double target = 0;               // seconds
+  double spin_threshold = 0.002;   // seconds left to the deadline we busy-wait
+
+  // Over the last INTERVALS frames, in seconds
+  double mean() const;
+  double stddev() const;
+
+private:
+  static constexpr int INTERVALS = 120;
+
+  double frequency;
+  Uint64 last_start = 0;
+  Uint64 deadline = 0;
+  std::array<double, INTERVALS> intervals = {0};
+  int count = 0, next = 0;
+};
@@ -0,0 +1,389 @@
+#include "path.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Runs of open border tiles at least this long get an entrance at both ends,
+// shorter ones a single entrance in the middle
+static constexpr int LONG_ENTRANCE = 6;
+// The sentinel the hierarchical search reaches the goal through
+static constexpr int GOAL_NODE = TILE_COUNT;
+
+static bool open_is_worse(const PathScratch::Open &a, const PathScratch::Open &b)
+{
+  // Min heap on f, deeper nodes first on ties
+  return a.f > b.f || (a.f == b.f && a.g < b.g);
+}
+
+static uint32_t manhattan(int a, int b)
+{
+  return std::abs(a % MAP_SIZE - b % MAP_SIZE) + std::abs(a / MAP_SIZE - b / MAP_SIZE);
+}
+
+void PathScratch::begin()
+{
+  if (++generation == 0)
+    {
+      std::fill(stamp.begin(), stamp.end(), 0);
+      generation = 1;
+    }
+  open.clear();
+}
+
+void PathScratch::relax(int tile, uint32_t cost, int from, uint32_t heuristic)
+{
+  if (seen(tile) && g[tile] <= cost) return;
+
+  stamp[tile] = generation;
+  g[tile] = cost;
+  parent[tile] = from;
+  open.push_back({cost + heuristic, cost, tile});
+  std::push_heap(open.begin(), open.end(), open_is_worse);
+}
+
+// Stale entries (the tile was reached cheaper since) are skipped
+bool PathScratch::pop(Open &node)
+{
+  while (!open.empty())
+    {
+      std::pop_heap(open.begin(), open.end(), open_is_worse);
+      node = open.back();
+      open.pop_back();
+      if (node.g == g[node.tile]) return true;
+    }
+  return false;
+}
+
+PathFinder::PathFinder(const TileMap &tiles) : tiles(tiles)
+{
+}
+
+SDL_Rect PathFinder::cluster_rect(int cluster)
+{
+  return {(cluster % CHUNK_COUNT) * CHUNK_SIZE, (cluster / CHUNK_COUNT) * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE};
+}
+
+void PathFinder::invalidate()
+{
+  for (auto &cluster : clusters) cluster.dirty = true;
+  dirty = true;
+}
+
+void PathFinder::mark_cluster_dirty(int cluster)
+{
+  clusters[cluster].dirty = true;
+  dirty = true;
+}
+
+void PathFinder::mark_dirty(int index)
+{
+  const int x = index % MAP_SIZE, y = index / MAP_SIZE;
+  const int cluster = cluster_of(index);
+  mark_cluster_dirty(cluster);
+
+  if (x % CHUNK_SIZE == 0 && x > 0) mark_cluster_dirty(cluster - 1);
+  if (x % CHUNK_SIZE == CHUNK_SIZE - 1 && x < MAP_SIZE - 1) mark_cluster_dirty(cluster + 1);
+  if (y % CHUNK_SIZE == 0 && y > 0) mark_cluster_dirty(cluster - CHUNK_COUNT);
+  if (y % CHUNK_SIZE == CHUNK_SIZE - 1 && y < MAP_SIZE - 1) mark_cluster_dirty(cluster + CHUNK_COUNT);
+}
+
+void PathFinder::refresh()
+{
+  if (!dirty) return;
+
+  for (int index = 0; index < CHUNK_COUNT * CHUNK_COUNT; ++index)
+    {
+      if (clusters[index].dirty) rebuild_cluster(index);
+    }
+  dirty = false;
+}
+
+// `start` is the first tile of a cluster edge, `along` steps along the edge and
+// `across` to the tile on the other side. Both clusters of a border walk it in
+// the same direction, so they pick matching entrances.
+void PathFinder::add_entrances(Cluster &cluster, int start, int along, int across)
+{
+  auto add = [&](int tile)
+  {
+    // Corner tiles can sit on two borders
+    if (slots[tile] >= 0) return;
+    slots[tile] = static_cast<int8_t>(cluster.entrances.size());
+    cluster.entrances.push_back(tile);
+  };
+
+  int run = 0;
+  for (int i = 0; i <= CHUNK_SIZE; ++i)
+    {
+      const int tile = start + i * along;
+      if (i < CHUNK_SIZE && TERRAIN_COST[tiles.kinds[tile]] && TERRAIN_COST[tiles.kinds[tile + across]])
+        {
+          ++run;
+          continue;
+        }
+      if (run == 0) continue;
+
+      const int first = i - run;
+      if (run >= LONG_ENTRANCE)
+        {
+          add(start + first * along);
+          add(start + (i - 1) * along);
+        }
+      else
+        {
+          add(start + (first + (run - 1) / 2) * along);
+        }
+      run = 0;
+    }
+}
+
+void PathFinder::rebuild_cluster(int index)
+{
+  Cluster &cluster = clusters[index];
+  for (int tile : cluster.entrances) slots[tile] = -1;
+  cluster.entrances.clear();
+
+  const SDL_Rect rect = cluster_rect(index);
+  const int top_left = rect.y * MAP_SIZE + rect.x;
+  const int bottom_left = (rect.y + CHUNK_SIZE - 1) * MAP_SIZE + rect.x;
+  const int top_right = top_left + CHUNK_SIZE - 1;
+
+  if (rect.y > 0) add_entrances(cluster, top_left, 1, -MAP_SIZE);
+  if (rect.x + CHUNK_SIZE < MAP_SIZE) add_entrances(cluster, top_right, MAP_SIZE, 1);
+  if (rect.y + CHUNK_SIZE < MAP_SIZE) add_entrances(cluster, bottom_left, 1, MAP_SIZE);
+  if (rect.x > 0) add_entrances(cluster, top_left, MAP_SIZE, -1);
+
+  // One Dijkstra per entrance fills its row of the cost matrix
+  const int count = static_cast<int>(cluster.entrances.size());
+  cluster.costs.assign(count * count, -1);
+  for (int i = 0; i < count; ++i)
+    {
+      search(scratch, cluster.entrances[i], -1, rect);
+      for (int j = 0; j < count; ++j)
+        {
+          const int tile = cluster.entrances[j];
+          if (scratch.seen(tile)) cluster.costs[i * count + j] = static_cast<int>(scratch.g[tile]);
+        }
+    }
+
+  cluster.dirty = false;
+  ++rebuilt;
+}
+
+int PathFinder::search(PathScratch &s, int from, int to, const SDL_Rect &bounds) const
+{
+  static constexpr int DX[4] = {0, 1, 0, -1};
+  static constexpr int DY[4] = {-1, 0, 1, 0};
+
+  // Every passable step costs at least 1, so Manhattan distance is admissible
+  auto heuristic = [&](int tile) { return to < 0 ? 0 : manhattan(tile, to); };
+
+  s.begin();
+  s.relax(from, 0, -1, heuristic(from));
+
+  PathScratch::Open node;
+  while (s.pop(node))
+    {
+      if (node.tile == to) return static_cast<int>(node.g);
+
+      const int x = node.tile % MAP_SIZE, y = node.tile / MAP_SIZE;
+      for (int dir = 0; dir < 4; ++dir)
+        {
+          const int nx = x + DX[dir], ny = y + DY[dir];
+          if (nx < bounds.x || ny < bounds.y || nx >= bounds.x + bounds.w || ny >= bounds.y + bounds.h) continue;
+
+          const int next = ny * MAP_SIZE + nx;
+          const uint8_t cost = TERRAIN_COST[tiles.kinds[next]];
+          if (cost) s.relax(next, node.g + cost, node.tile, heuristic(next));
+        }
+    }
+  return -1;
+}
+
+void PathFinder::trace(const PathScratch &s, int from, int to, std::vector<int> &out) const
+{
+  const size_t first = out.size();
+  for (int tile = to; tile != from; tile = s.parent[tile])
+    {
+      out.push_back(tile);
+    }
+  std::reverse(out.begin() + first, out.end());
+}
+
+int PathFinder::find_hierarchical(PathScratch &s, int from, int to, std::vector<int> &out) const
+{
+  const int from_cluster = cluster_of(from), to_cluster = cluster_of(to);
+
+  // Within one cluster the direct path is usually the answer, leaving the
+  // cluster is only tried when there's none
+  if (from_cluster == to_cluster)
+    {
+      const int cost = search(s, from, to, cluster_rect(from_cluster));
+      if (cost >= 0)
+        {
+          out.push_back(from);
+          trace(s, from, to, out);
+          return cost;
+        }
+    }
+
+  // Connect the endpoints to the entrances of their clusters. Costs are paid
+  // entering a tile, so the reverse of a path costs cost(start) - cost(end) more.
+  const Cluster &start = clusters[from_cluster];
+  const Cluster &goal = clusters[to_cluster];
+
+  search(s, from, -1, cluster_rect(from_cluster));
+  s.start_costs.clear();
+  for (int tile : start.entrances)
+    {
+      s.start_costs.push_back(s.seen(tile) ? static_cast<int>(s.g[tile]) : -1);
+    }
+
+  search(s, to, -1, cluster_rect(to_cluster));
+  s.goal_costs.clear();
+  for (int tile : goal.entrances)
+    {
+      const int cost = TERRAIN_COST[tiles.kinds[to]] - TERRAIN_COST[tiles.kinds[tile]];
+      s.goal_costs.push_back(s.seen(tile) ? static_cast<int>(s.g[tile]) + cost : -1);
+    }
+
+  // A* over the entrances, the goal is reached through a sentinel node
+  s.begin();
+  for (size_t i = 0; i < start.entrances.size(); ++i)
+    {
+      if (s.start_costs[i] >= 0) s.relax(start.entrances[i], s.start_costs[i], from, manhattan(start.entrances[i], to));
+    }
+
+  static constexpr int DX[4] = {0, 1, 0, -1};
+  static constexpr int DY[4] = {-1, 0, 1, 0};
+  bool found = false;
+
+  PathScratch::Open node;
+  while (s.pop(node))
+    {
+      if (node.tile == GOAL_NODE)
+        {
+          found = true;
+          break;
+        }
+
+      const int cluster_index = cluster_of(node.tile);
+      const Cluster &cluster = clusters[cluster_index];
+      const int slot = slots[node.tile];
+      const int count = static_cast<int>(cluster.entrances.size());
+
+      if (cluster_index == to_cluster && s.goal_costs[slot] >= 0)
+        {
+          s.relax(GOAL_NODE, node.g + s.goal_costs[slot], node.tile, 0);
+        }
+
+      for (int j = 0; j < count; ++j)
+        {
+          const int cost = cluster.costs[slot * count + j];
+          if (cost > 0) s.relax(cluster.entrances[j], node.g + cost, node.tile, manhattan(cluster.entrances[j], to));
+        }
+
+      // Entrances face each other across the border
+      const int x = node.tile % MAP_SIZE, y = node.tile / MAP_SIZE;
+      for (int dir = 0; dir < 4; ++dir)
+        {
+          const int nx = x + DX[dir], ny = y + DY[dir];
+          if (nx < 0 || ny < 0 || nx >= MAP_SIZE || ny >= MAP_SIZE) continue;
+
+          const int next = ny * MAP_SIZE + nx;
+          if (slots[next] < 0 || cluster_of(next) == cluster_index) continue;
+          s.relax(next, node.g + TERRAIN_COST[tiles.kinds[next]], node.tile, manhattan(next, to));
+        }
+    }
+  if (!found) return -1;
+
+  const int cost = static_cast<int>(s.g[GOAL_NODE]);
+  s.abstract.clear();
+  for (int tile = s.parent[GOAL_NODE]; tile != from; tile = s.parent[tile])
+    {
+      s.abstract.push_back(tile);
+    }
+  std::reverse(s.abstract.begin(), s.abstract.end());
+  s.abstract.push_back(to);
+
+  // Refine hop by hop: a hop either crosses a border or stays in one cluster
+  out.push_back(from);
+  int previous = from;
+  for (int tile : s.abstract)
+    {
+      if (tile == previous) continue;
+
+      if (cluster_of(tile) != cluster_of(previous))
+        {
+          out.push_back(tile);
+        }
+      else
+        {
+          search(s, previous, tile, cluster_rect(cluster_of(tile)));
+          trace(s, previous, tile, out);
+        }
+      previous = tile;
+    }
+  return cost;
+}
+
+int PathFinder::find(PathScratch &s, int from, int to, std::vector<int> &out, PathMode mode) const
+{
+  if (from < 0 || to < 0 || from >= TILE_COUNT || to >= TILE_COUNT) return -1;
+  if (!TERRAIN_COST[tiles.kinds[from]] || !TERRAIN_COST[tiles.kinds[to]]) return -1;
+
+  if (from == to)
+    {
+      out.push_back(from);
+      return 0;
+    }
+
+  if (mode == PathMode::Hierarchical) return find_hierarchical(s, from, to, out);
+
+  const int cost = search(s, from, to, {0, 0, MAP_SIZE, MAP_SIZE});
+  if (cost < 0) return -1;
+
+  out.push_back(from);
+  trace(s, from, to, out);
+  return cost;
+}
+
+int PathFinder::find_path(int from, int to, std::vector<int> &out, PathMode mode)
+{
+  refresh();
+  out.clear();
+  return find(scratch, from, to, out, mode);
+}
+
+// The graph is brought up to date first, the jobs only read it. Requests are
+// split in one batch per worker, each batch with its own scratch.
+void PathFinder::find_paths(JobSystem &jobs, const std::vector<PathRequest> &requests, std::vector<PathResult> &results, PathMode mode)
+{
+  refresh();
+  results.resize(requests.size());
+  if (requests.empty()) return;
+
+  const int batches = std::min(static_cast<int>(requests.size()), std::max(1, jobs.worker_count()));
+  while (static_cast<int>(worker_scratch.size()) < batches)
+    {
+      worker_scratch.push_back(std::make_unique<PathScratch>());
+    }
+
+  JobGroup group;
+  for (int batch = 0; batch < batches; ++batch)
+    {
+      const size_t first = requests.size() * batch / batches;
+      const size_t last = requests.size() * (batch + 1) / batches;
+      PathScratch *s = worker_scratch[batch].get();
+
+      jobs.submit([this, &requests, &results, mode, first, last, s]
+        {
+          for (size_t i = first; i < last; ++i)
+            {
+              results[i].tiles.clear();
+              results[i].cost = find(*s, requests[i].from, requests[i].to, results[i].tiles, mode);
+            }
+        }, &group);
+    }
+  // Not `wait_idle`, which would also wait for chunks and textures in flight
+  jobs.wait(group);
+}
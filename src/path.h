@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+#include "jobs.h"
+
+// Cost of stepping onto a tile of each kind, 0 is impassable
+inline constexpr uint8_t TERRAIN_COST[TERRAIN_KIND_COUNT] = {
+    0, // Crust
+    0, // Water
+    2, // Dirt
+    1, // Grass
+    2, // Sand
+    3, // Snow
+    2, // Forest
+    0, // Mountain
+    4, // Swamp
+    0, // Lava
+};
+
+enum class PathMode
+{
+  Grid,         // plain A* over the tiles, optimal
+  Hierarchical, // A* over the cluster graph, then refined cluster by cluster
+};
+
+struct PathRequest
+{
+  int from, to;
+};
+
+struct PathResult
+{
+  int cost = -1; // -1 when there is no path
+  std::vector<int> tiles;
+};
+
+// State of one search. Sized for the whole map and reused: a tile's entries are
+// only valid when its stamp is the current generation, so nothing is cleared
+// between searches. Every thread searching needs its own.
+struct PathScratch
+{
+  struct Open
+  {
+    uint32_t f, g;
+    int tile;
+  };
+
+  std::vector<uint32_t> g = std::vector<uint32_t>(TILE_COUNT + 1);
+  std::vector<uint32_t> stamp = std::vector<uint32_t>(TILE_COUNT + 1, 0);
+  std::vector<int> parent = std::vector<int>(TILE_COUNT + 1);
+  uint32_t generation = 0;
+  std::vector<Open> open;
+
+  std::vector<int> abstract, start_costs, goal_costs;
+
+  void begin();
+  bool seen(int tile) const { return stamp[tile] == generation; }
+  // Record `tile` reached with cost `cost` through `from` if that's an improvement
+  void relax(int tile, uint32_t cost, int from, uint32_t heuristic);
+  bool pop(Open &node);
+};
+
+// Paths over 4-connected tiles, weighted by TERRAIN_COST.
+//
+// The hierarchical mode follows HPA*: chunks are clusters, every run of open
+// tiles along a cluster border gets one or two entrances (a tile on each side)
+// and the costs between the entrances of a cluster are cached. A query connects
+// its endpoints to their cluster's entrances, searches that small graph and
+// then refines each hop with a search bounded to one cluster. Paths are near
+// optimal.
+//
+// A changed tile only dirties its cluster, and the cluster across the border
+// when the tile is on one since they share the entrances. Dirty clusters are
+// rebuilt by the next query.
+class PathFinder
+{
+public:
+  explicit PathFinder(const TileMap &tiles);
+
+  void invalidate();
+  void mark_dirty(int index);
+  void mark_cluster_dirty(int cluster);
+
+  // Writes the tiles from `from` to `to` inclusive to `out` and returns the
+  // cost, -1 when there is no path
+  int find_path(int from, int to, std::vector<int> &out, PathMode mode = PathMode::Hierarchical);
+  // Runs the requests on the worker pool and waits for them
+  void find_paths(JobSystem &jobs, const std::vector<PathRequest> &requests, std::vector<PathResult> &results,
+                  PathMode mode = PathMode::Hierarchical);
+
+  int rebuilt_count() const { return rebuilt; } // clusters rebuilt so far
+
+private:
+  // An entrance is a tile of the cluster, `costs` is entrances x entrances,
+  // row major, with -1 for the pairs that are not connected inside the cluster
+  struct Cluster
+  {
+    std::vector<int> entrances;
+    std::vector<int> costs;
+    bool dirty = true;
+  };
+
+  static int cluster_of(int index) { return (index / MAP_SIZE / CHUNK_SIZE) * CHUNK_COUNT + (index % MAP_SIZE) / CHUNK_SIZE; }
+  static SDL_Rect cluster_rect(int cluster);
+
+  void refresh();
+  void rebuild_cluster(int cluster);
+  void add_entrances(Cluster &cluster, int start, int along, int across);
+
+  // A* from `from` to `to` staying inside `bounds`, or Dijkstra over all of
+  // `bounds` when `to` is -1. Returns the cost to `to`.
+  int search(PathScratch &scratch, int from, int to, const SDL_Rect &bounds) const;
+  // Append the tiles after `from` up to `to` found by the last search
+  void trace(const PathScratch &scratch, int from, int to, std::vector<int> &out) const;
+  int find(PathScratch &scratch, int from, int to, std::vector<int> &out, PathMode mode) const;
+  int find_hierarchical(PathScratch &scratch, int from, int to, std::vector<int> &out) const;
+
+  const TileMap &tiles;
+  std::vector<Cluster> clusters = std::vector<Cluster>(CHUNK_COUNT * CHUNK_COUNT);
+  std::vector<int8_t> slots = std::vector<int8_t>(TILE_COUNT, -1); // entrance index in its cluster
+  bool dirty = true;
+  int rebuilt = 0;
+
+  PathScratch scratch;
+  std::vector<std::unique_ptr<PathScratch>> worker_scratch;
+};
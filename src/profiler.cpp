@@ -0,0 +1,133 @@
+#include "profiler.h"
+
+#include <cstdio>
+
+#include <imgui.h>
+
+Profiler profiler;
+
+void Profiler::begin_frame()
+{
+  auto &frame = frames[current];
+  frame.start = SDL_GetPerformanceCounter();
+  frame.end = frame.start;
+  frame.zone_count = 0;
+  depth = 0;
+}
+
+void Profiler::end_frame()
+{
+  frames[current].end = SDL_GetPerformanceCounter();
+  current = (current + 1) % FRAME_COUNT;
+  ++completed;
+}
+
+int Profiler::begin_zone(const char *name)
+{
+  auto &frame = frames[current];
+  if (frame.zone_count >= MAX_ZONES) return -1;
+
+  const int zone = frame.zone_count++;
+  frame.zones[zone] = {name, SDL_GetPerformanceCounter(), 0, depth++};
+  return zone;
+}
+
+void Profiler::end_zone(int zone)
+{
+  if (zone < 0) return;
+  frames[current].zones[zone].end = SDL_GetPerformanceCounter();
+  --depth;
+}
+
+bool Profiler::export_chrome_trace(const char *path, int count) const
+{
+  FILE *file = fopen(path, "w");
+  if (!file)
+    {
+      SDL_Log("Couldn't open trace file '%s'", path);
+      return false;
+    }
+
+  count = count < frame_count() ? count : frame_count();
+  const double us = 1000000.0 / SDL_GetPerformanceFrequency();
+  const Uint64 origin = count > 0 ? frame(count - 1).start : 0;
+  bool first = true;
+
+  fprintf(file, "{\"traceEvents\":[\n");
+  for (int age = count - 1; age >= 0; --age)
+    {
+      const auto &f = frame(age);
+      fprintf(file, "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+              first ? "" : ",\n", (f.start - origin) * us, (f.end - f.start) * us);
+      first = false;
+
+      for (int i = 0; i < f.zone_count; ++i)
+        {
+          const auto &z = f.zones[i];
+          fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+                  z.name, (z.start - origin) * us, (z.end - z.start) * us);
+        }
+    }
+  fprintf(file, "\n]}\n");
+  fclose(file);
+
+  SDL_Log("Wrote %d frames to '%s'", count, path);
+  return true;
+}
+
+void Profiler::draw_overlay(bool *open)
+{
+  if (!ImGui::Begin("Profiler", open))
+    {
+      ImGui::End();
+      return;
+    }
+
+  const int count = frame_count();
+  if (count == 0)
+    {
+      ImGui::TextUnformatted("No frame recorded (zones are disabled in release builds)");
+      ImGui::End();
+      return;
+    }
+
+  std::array<float, FRAME_COUNT> times;
+  float worst = 0;
+  for (int i = 0; i < count; ++i)
+    {
+      const auto &f = frame(count - 1 - i);
+      times[i] = static_cast<float>(to_ms(f.end - f.start));
+      worst = times[i] > worst ? times[i] : worst;
+    }
+
+  const auto &last = frame(0);
+  ImGui::Text("frame: %.3f ms, worst of %d: %.3f ms", to_ms(last.end - last.start), count, worst);
+  ImGui::PlotLines("##frames", times.data(), count, 0, nullptr, 0.0f, worst, ImVec2(0, 80));
+
+  if (ImGui::BeginTable("zones", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+      ImGui::TableSetupColumn("zone");
+      ImGui::TableSetupColumn("ms");
+      ImGui::TableHeadersRow();
+      for (int i = 0; i < last.zone_count; ++i)
+        {
+          const auto &z = last.zones[i];
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::Text("%*s%s", z.depth * 2, "", z.name);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", to_ms(z.end - z.start));
+        }
+      ImGui::EndTable();
+    }
+
+  static int export_frames = 120;
+  ImGui::SliderInt("frames", &export_frames, 1, count);
+  ImGui::SameLine();
+  if (ImGui::Button("Export trace"))
+    {
+      export_chrome_trace("trace.json", export_frames);
+    }
+
+  ImGui::End();
+}
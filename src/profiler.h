@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <SDL3/SDL.h>
+
+// Scoped timing zones recorded into a ring buffer of the last FRAME_COUNT
+// frames. Zones are main thread only. The caller brackets a frame with
+// PROFILE_FRAME_BEGIN/END around its input, fixed updates and rendering.
+//
+//   void Game::render() { PROFILE_ZONE("render"); ... }
+//
+// Zones compile to nothing unless GAME_PROFILE is defined (the build sets it
+// for every configuration except Release and MinSizeRel).
+class Profiler
+{
+public:
+  static constexpr int FRAME_COUNT = 256;
+  static constexpr int MAX_ZONES = 256; // per frame, catch-up updates included, extra zones are dropped
+
+  struct Zone
+  {
+    const char *name;
+    Uint64 start, end;
+    int depth;
+  };
+
+  struct Frame
+  {
+    Uint64 start = 0, end = 0;
+    int zone_count = 0;
+    std::array<Zone, MAX_ZONES> zones;
+  };
+
+  void begin_frame();
+  void end_frame();
+
+  int begin_zone(const char *name);
+  void end_zone(int zone);
+
+  // `age` 0 is the last completed frame
+  const Frame &frame(int age) const { return frames[(current - 1 - age + FRAME_COUNT) % FRAME_COUNT]; }
+  int frame_count() const { return completed < FRAME_COUNT - 1 ? completed : FRAME_COUNT - 1; }
+  double to_ms(Uint64 ticks) const { return ticks * 1000.0 / SDL_GetPerformanceFrequency(); }
+
+  // Write the last `count` frames as Chrome trace JSON (chrome://tracing, Perfetto)
+  bool export_chrome_trace(const char *path, int count) const;
+  // ImGui window with the frame time graph and the zones of the last frame
+  void draw_overlay(bool *open);
+
+private:
+  std::array<Frame, FRAME_COUNT> frames;
+  int current = 0;
+  int completed = 0;
+  int depth = 0;
+};
+
+extern Profiler profiler;
+
+struct ProfileScope
+{
+  int zone;
+  explicit ProfileScope(const char *name) : zone(profiler.begin_zone(name)) {}
+  ~ProfileScope() { profiler.end_zone(zone); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef GAME_PROFILE
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FRAME_BEGIN() profiler.begin_frame()
+#define PROFILE_FRAME_END() profiler.end_frame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FRAME_BEGIN()
+#define PROFILE_FRAME_END()
+#endif
@@ -0,0 +1,253 @@
+#include "query.h"
+
+static SDL_Rect clamp_to_map(SDL_Rect area)
+{
+  const int x0 = std::max(0, area.x);
+  const int y0 = std::max(0, area.y);
+  const int x1 = std::min(MAP_SIZE, area.x + area.w);
+  const int y1 = std::min(MAP_SIZE, area.y + area.h);
+  return {x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
+}
+
+void TerrainQuery::refresh()
+{
+  if (!dirty) return;
+
+  rebuild_table();
+  rebuild_pyramid();
+  dirty = false;
+}
+
+// Every tile counted in its own cell, then each cell added to its parent
+// along x and then along y, which is the tree in linear time
+void TerrainQuery::rebuild_table()
+{
+  for (auto &plane : table) plane.assign(STRIDE * STRIDE, 0);
+
+  for (int y = 0; y < MAP_SIZE; ++y)
+    {
+      const TerrainKind *row = &tiles.kinds[y * MAP_SIZE];
+      for (int x = 0; x < MAP_SIZE; ++x)
+        {
+          table[row[x]][(y + 1) * STRIDE + x + 1] = 1;
+        }
+    }
+
+  for (auto &t : table)
+    {
+      for (int y = 1; y <= MAP_SIZE; ++y)
+        {
+          for (int x = 1; x <= MAP_SIZE; ++x)
+            {
+              const int parent = x + (x & -x);
+              if (parent <= MAP_SIZE) t[y * STRIDE + parent] += t[y * STRIDE + x];
+            }
+        }
+      for (int y = 1; y <= MAP_SIZE; ++y)
+        {
+          const int parent = y + (y & -y);
+          if (parent > MAP_SIZE) continue;
+          for (int x = 1; x <= MAP_SIZE; ++x)
+            {
+              t[parent * STRIDE + x] += t[y * STRIDE + x];
+            }
+        }
+    }
+}
+
+// Tiles of `kind` in [0, x) x [0, y)
+int TerrainQuery::prefix(TerrainKind kind, int x, int y) const
+{
+  const auto &t = table[kind];
+  uint32_t sum = 0;
+  for (int j = y; j > 0; j -= j & -j)
+    {
+      for (int i = x; i > 0; i -= i & -i)
+        {
+          sum += t[j * STRIDE + i];
+        }
+    }
+  return static_cast<int>(sum);
+}
+
+void TerrainQuery::rebuild_pyramid()
+{
+  pyramid[0].assign(tiles.kinds.begin(), tiles.kinds.end());
+
+  for (int level = 1; level < LEVELS; ++level)
+    {
+      const int size = MAP_SIZE >> level;
+      const int child_size = size * 2;
+      const auto &children = pyramid[level - 1];
+      auto &cells = pyramid[level];
+      cells.resize(size * size);
+
+      for (int y = 0; y < size; ++y)
+        {
+          for (int x = 0; x < size; ++x)
+            {
+              const uint8_t a = children[(2 * y) * child_size + 2 * x];
+              const uint8_t b = children[(2 * y) * child_size + 2 * x + 1];
+              const uint8_t c = children[(2 * y + 1) * child_size + 2 * x];
+              const uint8_t d = children[(2 * y + 1) * child_size + 2 * x + 1];
+              cells[y * size + x] = (a == b && a == c && a == d) ? a : MIXED;
+            }
+        }
+    }
+
+  for (int level = 0; level < LEVELS; ++level)
+    {
+      stamps[level].assign(pyramid[level].size(), 0);
+    }
+  fill_generation = 0;
+}
+
+void TerrainQuery::update_pyramid(int x, int y)
+{
+  pyramid[0][y * MAP_SIZE + x] = tiles.kinds[y * MAP_SIZE + x];
+
+  for (int level = 1; level < LEVELS; ++level)
+    {
+      const int size = MAP_SIZE >> level;
+      const int child_size = size * 2;
+      const int cx = (x >> level) * 2;
+      const int cy = (y >> level) * 2;
+      const auto &children = pyramid[level - 1];
+
+      const uint8_t a = children[cy * child_size + cx];
+      const uint8_t b = children[cy * child_size + cx + 1];
+      const uint8_t c = children[(cy + 1) * child_size + cx];
+      const uint8_t d = children[(cy + 1) * child_size + cx + 1];
+      pyramid[level][(y >> level) * size + (x >> level)] = (a == b && a == c && a == d) ? a : MIXED;
+    }
+}
+
+// Moves one tile from `previous` to `kind` in the O(log^2) tree cells that
+// cover it
+void TerrainQuery::set(int index, TerrainKind previous, TerrainKind kind)
+{
+  if (dirty || previous == kind) return;
+
+  const int tx = index % MAP_SIZE;
+  const int ty = index / MAP_SIZE;
+  auto &from = table[previous];
+  auto &to = table[kind];
+
+  for (int y = ty + 1; y <= MAP_SIZE; y += y & -y)
+    {
+      for (int x = tx + 1; x <= MAP_SIZE; x += x & -x)
+        {
+          --from[y * STRIDE + x];
+          ++to[y * STRIDE + x];
+        }
+    }
+
+  update_pyramid(tx, ty);
+}
+
+int TerrainQuery::count(TerrainKind kind, SDL_Rect area)
+{
+  refresh();
+  area = clamp_to_map(area);
+  if (area.w == 0 || area.h == 0) return 0;
+
+  const int x0 = area.x, y0 = area.y, x1 = area.x + area.w, y1 = area.y + area.h;
+  return prefix(kind, x1, y1) - prefix(kind, x1, y0) - prefix(kind, x0, y1) + prefix(kind, x0, y0);
+}
+
+// Is the part of square (level, bx, by) inside [x0, x1) x [y0, y1) all `kind`?
+// `kind` is MIXED until the first uniform square sets it.
+bool TerrainQuery::uniform_block(int level, int bx, int by, int x0, int y0, int x1, int y1, uint8_t &kind) const
+{
+  const int size = 1 << level;
+  const int left = bx * size, top = by * size;
+  if (left >= x1 || top >= y1 || left + size <= x0 || top + size <= y0) return true;
+
+  const uint8_t value = pyramid[level][by * (MAP_SIZE >> level) + bx];
+  if (value != MIXED)
+    {
+      if (kind == MIXED) kind = value;
+      return value == kind;
+    }
+
+  // A mixed square entirely inside the area can't be uniform
+  if (left >= x0 && top >= y0 && left + size <= x1 && top + size <= y1) return false;
+
+  for (int i = 0; i < 4; ++i)
+    {
+      if (!uniform_block(level - 1, bx * 2 + (i & 1), by * 2 + (i >> 1), x0, y0, x1, y1, kind)) return false;
+    }
+  return true;
+}
+
+bool TerrainQuery::is_uniform(SDL_Rect area, TerrainKind *kind)
+{
+  refresh();
+  area = clamp_to_map(area);
+  if (area.w == 0 || area.h == 0) return false;
+
+  uint8_t value = MIXED;
+  if (!uniform_block(LEVELS - 1, 0, 0, area.x, area.y, area.x + area.w, area.y + area.h, value)) return false;
+
+  if (kind) *kind = static_cast<TerrainKind>(value);
+  return true;
+}
+
+// Walks maximal uniform squares instead of tiles: every square is taken whole
+// and only the tiles along its outside border are looked at next.
+int TerrainQuery::flood_fill(int index, std::vector<SDL_Rect> &out)
+{
+  refresh();
+  if (index < 0 || index >= TILE_COUNT) return 0;
+
+  if (++fill_generation == 0)
+    {
+      for (auto &level : stamps) std::fill(level.begin(), level.end(), 0);
+      fill_generation = 1;
+    }
+
+  const uint8_t kind = tiles.kinds[index];
+  int filled = 0;
+
+  stack.clear();
+  stack.push_back(index);
+  while (!stack.empty())
+    {
+      const int tile = stack.back();
+      stack.pop_back();
+
+      const int x = tile % MAP_SIZE;
+      const int y = tile / MAP_SIZE;
+
+      // Squares are aligned quadtree nodes, so the largest uniform one that
+      // contains a tile is unique and squares found this way never overlap
+      int level = 0;
+      while (level + 1 < LEVELS && cell(level + 1, x, y) == kind) ++level;
+
+      const int size = 1 << level;
+      uint32_t &stamp = stamps[level][(y >> level) * (MAP_SIZE >> level) + (x >> level)];
+      if (stamp == fill_generation) continue;
+      stamp = fill_generation;
+
+      const int left = (x >> level) << level;
+      const int top = (y >> level) << level;
+      out.push_back({left, top, size, size});
+      filled += size * size;
+
+      auto visit = [&](int nx, int ny)
+      {
+        if (nx < 0 || ny < 0 || nx >= MAP_SIZE || ny >= MAP_SIZE) return;
+        if (tiles.kinds[ny * MAP_SIZE + nx] == kind) stack.push_back(ny * MAP_SIZE + nx);
+      };
+
+      for (int i = 0; i < size; ++i)
+        {
+          visit(left + i, top - 1);
+          visit(left + i, top + size);
+          visit(left - 1, top + i);
+          visit(left + size, top + i);
+        }
+    }
+
+  return filled;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+
+static_assert((MAP_SIZE & (MAP_SIZE - 1)) == 0, "the region quadtree needs a power of two MAP_SIZE");
+
+// Spatial queries over the kind plane, for placement rules and overlays:
+//
+// - a 2D Fenwick tree per TerrainKind, so counting a kind in any rectangle
+//   and moving a tile from one kind to another both take O(log^2 MAP_SIZE);
+// - a quadtree of uniform regions, stored as a pyramid where level L holds one
+//   cell per aligned (1 << L) square: its kind when the whole square has that
+//   kind, MIXED otherwise. Uniformity checks and flood fills can then skip
+//   whole squares at once.
+//
+// Single tile changes go through `set`. Bulk changes (chunk generation, brush
+// strokes) call `invalidate`, and everything is rebuilt on the next query.
+class TerrainQuery
+{
+public:
+  explicit TerrainQuery(const TileMap &tiles) : tiles(tiles) {}
+
+  void invalidate() { dirty = true; }
+  void set(int index, TerrainKind previous, TerrainKind kind);
+
+  // `area` is in tile coordinates and clamped to the map
+  int count(TerrainKind kind, SDL_Rect area);
+  // True when every tile in `area` has the same kind, written to `kind`
+  bool is_uniform(SDL_Rect area, TerrainKind *kind = nullptr);
+  // 4-connected region of tiles with the same kind as `index`, as disjoint
+  // squares appended to `out`. Returns the tile count.
+  int flood_fill(int index, std::vector<SDL_Rect> &out);
+
+private:
+  static constexpr uint8_t MIXED = 0xff;
+  static constexpr int LEVELS = [] { int l = 0; while ((1 << l) < MAP_SIZE) ++l; return l + 1; }();
+  static constexpr int STRIDE = MAP_SIZE + 1;
+
+  void refresh();
+  void rebuild_table();
+  int prefix(TerrainKind kind, int x, int y) const;
+  void rebuild_pyramid();
+  void update_pyramid(int x, int y);
+  uint8_t cell(int level, int x, int y) const { return pyramid[level][(y >> level) * (MAP_SIZE >> level) + (x >> level)]; }
+  bool uniform_block(int level, int bx, int by, int x0, int y0, int x1, int y1, uint8_t &kind) const;
+
+  const TileMap &tiles;
+  bool dirty = true;
+
+  // Fenwick trees, 1-based: table[kind][y * STRIDE + x] sums the tiles of
+  // `kind` in (x - lowbit(x), x] x (y - lowbit(y), y]
+  std::array<std::vector<uint32_t>, TERRAIN_KIND_COUNT> table;
+  std::array<std::vector<uint8_t>, LEVELS> pyramid;
+
+  // flood fill scratch: a square is visited when its stamp is the current fill
+  std::array<std::vector<uint32_t>, LEVELS> stamps;
+  uint32_t fill_generation = 0;
+  std::vector<int> stack;
+};
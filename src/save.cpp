@@ -0,0 +1,301 @@
+#include "save.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr int CHUNK_TOTAL = CHUNK_COUNT * CHUNK_COUNT;
+static constexpr size_t DIRECTORY_OFFSET = sizeof(WorldHeader);
+static constexpr size_t PAYLOAD_OFFSET = DIRECTORY_OFFSET + CHUNK_TOTAL * sizeof(ChunkEntry);
+
+void encode_chunk(const TileMap &tiles, int chunk_index, std::vector<uint8_t> &out)
+{
+  const int cx = chunk_index % CHUNK_COUNT;
+  const int cy = chunk_index / CHUNK_COUNT;
+
+  int run = 0;
+  uint8_t value = 0;
+  for (int y = 0; y < CHUNK_SIZE; ++y)
+    {
+      for (int x = 0; x < CHUNK_SIZE; ++x)
+        {
+          const int index = (cy * CHUNK_SIZE + y) * MAP_SIZE + cx * CHUNK_SIZE + x;
+          const uint8_t tile = static_cast<uint8_t>(tiles.kinds[index] | (tiles.is_selected(index) << 7));
+
+          if (run > 0 && (tile != value || run == 255))
+            {
+              out.push_back(static_cast<uint8_t>(run));
+              out.push_back(value);
+              run = 0;
+            }
+          value = tile;
+          ++run;
+        }
+    }
+  out.push_back(static_cast<uint8_t>(run));
+  out.push_back(value);
+}
+
+bool decode_chunk(const uint8_t *data, size_t size, TileMap &tiles, int chunk_index)
+{
+  const int cx = chunk_index % CHUNK_COUNT;
+  const int cy = chunk_index / CHUNK_COUNT;
+
+  int tile = 0;
+  for (size_t i = 0; i + 1 < size; i += 2)
+    {
+      const int run = data[i];
+      const uint8_t value = data[i + 1];
+      const TerrainKind kind = static_cast<TerrainKind>(value & 0x7f);
+      const bool selected = value >> 7;
+
+      if (kind >= TERRAIN_KIND_COUNT || tile + run > CHUNK_SIZE * CHUNK_SIZE) return false;
+
+      for (int end = tile + run; tile < end; ++tile)
+        {
+          const int index = (cy * CHUNK_SIZE + tile / CHUNK_SIZE) * MAP_SIZE + cx * CHUNK_SIZE + tile % CHUNK_SIZE;
+          tiles.kinds[index] = kind;
+          if (tiles.is_selected(index) != selected) tiles.toggle_selected(index);
+        }
+    }
+
+  return tile == CHUNK_SIZE * CHUNK_SIZE;
+}
+
+bool WorldFile::open(const std::string &path)
+{
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    {
+      SDL_Log("Couldn't open world '%s'", path.c_str());
+      return false;
+    }
+  LARGE_INTEGER file_size;
+  GetFileSizeEx(file, &file_size);
+  HANDLE mapping = file_size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+  const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view)
+    {
+      SDL_Log("Couldn't map world '%s'", path.c_str());
+      if (mapping) CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+    }
+  file_handle = file;
+  mapping_handle = mapping;
+  size = static_cast<size_t>(file_size.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      SDL_Log("Couldn't open world '%s'", path.c_str());
+      return false;
+    }
+  struct stat st;
+  void *view = fstat(fd, &st) == 0 && st.st_size > 0
+    ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+    : MAP_FAILED;
+  ::close(fd); // the mapping keeps the file alive
+  if (view == MAP_FAILED)
+    {
+      SDL_Log("Couldn't map world '%s'", path.c_str());
+      return false;
+    }
+  size = static_cast<size_t>(st.st_size);
+#endif
+
+  data = static_cast<const uint8_t *>(view);
+  file_path = path;
+
+  if (size < PAYLOAD_OFFSET)
+    {
+      SDL_Log("World '%s' is truncated", path.c_str());
+      close();
+      return false;
+    }
+
+  SDL_memcpy(&header, data, sizeof header);
+  header.magic = SDL_Swap32LE(header.magic);
+  header.version = SDL_Swap16LE(header.version);
+  header.map_size = SDL_Swap32LE(header.map_size);
+  header.chunk_size = SDL_Swap32LE(header.chunk_size);
+  header.seed = static_cast<Sint32>(SDL_Swap32LE(static_cast<Uint32>(header.seed)));
+  header.chunk_count = SDL_Swap32LE(header.chunk_count);
+  header.generator_hash = SDL_Swap64LE(header.generator_hash);
+
+  if (header.magic != WORLD_MAGIC || header.version != WORLD_VERSION)
+    {
+      SDL_Log("'%s' is not a world file this version can read", path.c_str());
+      close();
+      return false;
+    }
+  if (header.map_size != MAP_SIZE || header.chunk_size != CHUNK_SIZE || header.chunk_count != CHUNK_TOTAL)
+    {
+      SDL_Log("World '%s' is %ux%u, this build expects %dx%d", path.c_str(), header.map_size, header.map_size, MAP_SIZE, MAP_SIZE);
+      close();
+      return false;
+    }
+
+  return true;
+}
+
+void WorldFile::close()
+{
+  if (!data) return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(data);
+  CloseHandle(mapping_handle);
+  CloseHandle(file_handle);
+  mapping_handle = file_handle = nullptr;
+#else
+  munmap(const_cast<uint8_t *>(data), size);
+#endif
+
+  data = nullptr;
+  size = 0;
+  header = {};
+}
+
+ChunkEntry WorldFile::entry(int chunk_index) const
+{
+  ChunkEntry result;
+  SDL_memcpy(&result, data + DIRECTORY_OFFSET + chunk_index * sizeof(ChunkEntry), sizeof result);
+  result.offset = SDL_Swap64LE(result.offset);
+  result.size = SDL_Swap32LE(result.size);
+  return result;
+}
+
+bool WorldFile::has_chunk(int chunk_index) const
+{
+  if (!data) return false;
+
+  const ChunkEntry e = entry(chunk_index);
+  return e.size > 0 && e.offset >= PAYLOAD_OFFSET && e.offset + e.size <= size;
+}
+
+bool WorldFile::load_chunk(int chunk_index, TileMap &tiles) const
+{
+  if (!has_chunk(chunk_index)) return false;
+
+  const ChunkEntry e = entry(chunk_index);
+  if (!decode_chunk(data + e.offset, e.size, tiles, chunk_index))
+    {
+      SDL_Log("Chunk %d of '%s' is corrupt", chunk_index, file_path.c_str());
+      return false;
+    }
+  return true;
+}
+
+static bool write_entry(SDL_IOStream *io, int chunk_index, const ChunkEntry &e)
+{
+  return SDL_SeekIO(io, DIRECTORY_OFFSET + chunk_index * sizeof(ChunkEntry), SDL_IO_SEEK_SET) >= 0
+    && SDL_WriteU64LE(io, e.offset)
+    && SDL_WriteU32LE(io, e.size)
+    && SDL_WriteU32LE(io, 0);
+}
+
+bool WorldFile::write(const std::string &path, int seed, uint64_t generator_hash, const TileMap &tiles,
+                      const std::vector<uint8_t> &stored, const WorldFile *previous)
+{
+  SDL_IOStream *io = SDL_IOFromFile(path.c_str(), "wb");
+  if (!io)
+    {
+      SDL_Log("Couldn't create world '%s': %s", path.c_str(), SDL_GetError());
+      return false;
+    }
+
+  bool ok = SDL_WriteU32LE(io, WORLD_MAGIC)
+    && SDL_WriteU16LE(io, WORLD_VERSION)
+    && SDL_WriteU16LE(io, 0)
+    && SDL_WriteU32LE(io, MAP_SIZE)
+    && SDL_WriteU32LE(io, CHUNK_SIZE)
+    && SDL_WriteS32LE(io, seed)
+    && SDL_WriteU32LE(io, CHUNK_TOTAL)
+    && SDL_WriteU64LE(io, generator_hash);
+
+  // The directory is written last, once the payload offsets are known
+  std::vector<ChunkEntry> directory(CHUNK_TOTAL, ChunkEntry{0, 0, 0});
+  std::vector<uint8_t> zeros(CHUNK_TOTAL * sizeof(ChunkEntry), 0);
+  ok = ok && SDL_WriteIO(io, zeros.data(), zeros.size()) == zeros.size();
+
+  std::vector<uint8_t> payload;
+  Uint64 offset = PAYLOAD_OFFSET;
+  for (int index = 0; ok && index < CHUNK_TOTAL; ++index)
+    {
+      const uint8_t *bytes = nullptr;
+      size_t count = 0;
+
+      if (stored[index])
+        {
+          payload.clear();
+          encode_chunk(tiles, index, payload);
+          bytes = payload.data();
+          count = payload.size();
+        }
+      else if (previous && previous->has_chunk(index))
+        {
+          const ChunkEntry e = previous->entry(index);
+          bytes = previous->data + e.offset;
+          count = e.size;
+        }
+
+      if (count == 0) continue;
+
+      ok = SDL_WriteIO(io, bytes, count) == count;
+      directory[index] = {offset, static_cast<Uint32>(count), 0};
+      offset += count;
+    }
+
+  for (int index = 0; ok && index < CHUNK_TOTAL; ++index)
+    {
+      ok = write_entry(io, index, directory[index]);
+    }
+
+  if (!SDL_CloseIO(io)) ok = false;
+  if (!ok) SDL_Log("Couldn't write world '%s': %s", path.c_str(), SDL_GetError());
+  return ok;
+}
+
+bool WorldFile::append(const TileMap &tiles, const std::vector<int> &chunk_indices)
+{
+  if (!data) return false;
+
+  const std::string path = file_path;
+  close(); // can't grow a file while it is mapped on every platform
+
+  SDL_IOStream *io = SDL_IOFromFile(path.c_str(), "r+b");
+  if (!io)
+    {
+      SDL_Log("Couldn't open world '%s' for writing: %s", path.c_str(), SDL_GetError());
+      return false;
+    }
+
+  bool ok = true;
+  std::vector<uint8_t> payload;
+  for (int index : chunk_indices)
+    {
+      payload.clear();
+      encode_chunk(tiles, index, payload);
+
+      const Sint64 offset = SDL_SeekIO(io, 0, SDL_IO_SEEK_END);
+      ok = offset >= 0
+        && SDL_WriteIO(io, payload.data(), payload.size()) == payload.size()
+        && write_entry(io, index, {static_cast<Uint64>(offset), static_cast<Uint32>(payload.size()), 0});
+      if (!ok) break;
+    }
+
+  if (!SDL_CloseIO(io)) ok = false;
+  if (!ok) SDL_Log("Couldn't update world '%s': %s", path.c_str(), SDL_GetError());
+
+  return open(path) && ok;
+}
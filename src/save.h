@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "tile.h"
+
+// Binary world format, all integers little endian:
+//
+//   WorldHeader
+//   ChunkEntry[chunk_count]   row major, size 0 when the chunk is not stored
+//   chunk payloads            anywhere after the directory
+//
+// A payload is the chunk's tiles, row major, run-length encoded as
+// (run length, value) byte pairs where value is `kind | selected << 7`.
+// Chunks that are not stored are regenerated from the seed, with the generator
+// config whose `GeneratorConfig::hash` is in the header. A world only loads
+// under that same config, or it would come out of mismatched chunks.
+inline constexpr Uint32 WORLD_MAGIC = 0x44575054; // "TPWD"
+inline constexpr Uint16 WORLD_VERSION = 2;
+
+struct WorldHeader
+{
+  Uint32 magic;
+  Uint16 version;
+  Uint16 reserved;
+  Uint32 map_size;
+  Uint32 chunk_size;
+  Sint32 seed;
+  Uint32 chunk_count;
+  Uint64 generator_hash;
+};
+
+struct ChunkEntry
+{
+  Uint64 offset;
+  Uint32 size;
+  Uint32 reserved;
+};
+
+static_assert(sizeof(WorldHeader) == 32 && sizeof(ChunkEntry) == 16, "on-disk layout");
+
+// Encode one chunk of `tiles`, appended to `out`
+void encode_chunk(const TileMap &tiles, int chunk_index, std::vector<uint8_t> &out);
+bool decode_chunk(const uint8_t *data, size_t size, TileMap &tiles, int chunk_index);
+
+// A world file mapped in memory. Chunks are only decoded when asked for, so
+// only the pages of the chunks we touch are ever read.
+class WorldFile
+{
+public:
+  ~WorldFile() { close(); }
+
+  bool open(const std::string &path);
+  void close();
+
+  bool is_open() const { return data != nullptr; }
+  const std::string &path() const { return file_path; }
+  int seed() const { return header.seed; }
+  uint64_t generator_hash() const { return header.generator_hash; }
+
+  bool has_chunk(int chunk_index) const;
+  bool load_chunk(int chunk_index, TileMap &tiles) const;
+
+  // Write a whole new file. `stored[i]` tells whether chunk i is in `tiles`,
+  // chunks that are not but are in `previous` are copied over as they are.
+  static bool write(const std::string &path, int seed, uint64_t generator_hash, const TileMap &tiles,
+                    const std::vector<uint8_t> &stored, const WorldFile *previous);
+  // Append the given chunks to the open file and point its directory at them,
+  // the file is mapped again afterwards
+  bool append(const TileMap &tiles, const std::vector<int> &chunk_indices);
+
+private:
+  ChunkEntry entry(int chunk_index) const;
+
+  std::string file_path;
+  WorldHeader header = {};
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  void *file_handle = nullptr;
+  void *mapping_handle = nullptr;
+#endif
+};
@@ -0,0 +1,154 @@
+#include "selection.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+int TileBits::count() const
+{
+  int count = 0;
+  for (uint64_t word : words) count += std::popcount(word);
+  return count;
+}
+
+void TileBits::unite(const TileBits &other)
+{
+  for (int i = 0; i < WORDS; ++i) words[i] |= other.words[i];
+}
+
+void TileBits::intersect(const TileBits &other)
+{
+  for (int i = 0; i < WORDS; ++i) words[i] &= other.words[i];
+}
+
+void TileBits::subtract(const TileBits &other)
+{
+  for (int i = 0; i < WORDS; ++i) words[i] &= ~other.words[i];
+}
+
+void TileBits::invert()
+{
+  for (uint64_t &word : words) word = ~word;
+}
+
+void TileBits::set_span(int y, int x0, int x1)
+{
+  x0 = std::max(0, x0);
+  x1 = std::min(MAP_SIZE, x1);
+  if (y < 0 || y >= MAP_SIZE || x0 >= x1) return;
+
+  uint64_t *row = &words[y * ROW_WORDS];
+  const int first = x0 >> 6, last = (x1 - 1) >> 6;
+  const uint64_t head = ~uint64_t{0} << (x0 & 63);
+  const uint64_t tail = ~uint64_t{0} >> (63 - ((x1 - 1) & 63));
+
+  if (first == last)
+    {
+      row[first] |= head & tail;
+      return;
+    }
+
+  row[first] |= head;
+  for (int w = first + 1; w < last; ++w) row[w] = ~uint64_t{0};
+  row[last] |= tail;
+}
+
+void TileBits::fill_rect(const SDL_Rect &area)
+{
+  const int y0 = std::max(0, area.y);
+  const int y1 = std::min(MAP_SIZE, area.y + area.h);
+  for (int y = y0; y < y1; ++y)
+    {
+      set_span(y, area.x, area.x + area.w);
+    }
+}
+
+void TileBits::fill_polygon(const std::vector<SDL_FPoint> &points, Arena &scratch)
+{
+  if (points.size() < 3) return;
+
+  float top = points[0].y, bottom = points[0].y;
+  for (const auto &p : points)
+    {
+      top = std::min(top, p.y);
+      bottom = std::max(bottom, p.y);
+    }
+
+  // Sample every row at the tile centers
+  const int y0 = std::max(0, static_cast<int>(SDL_ceilf(top - 0.5f)));
+  const int y1 = std::min(MAP_SIZE - 1, static_cast<int>(SDL_floorf(bottom - 0.5f)));
+  // A row crosses every edge at most once
+  ArenaScope scope(scratch);
+  float *crossings = scratch.allocate_array<float>(points.size());
+  size_t crossing_count = 0;
+
+  for (int y = y0; y <= y1; ++y)
+    {
+      const float center = y + 0.5f;
+      crossing_count = 0;
+
+      for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+        {
+          const SDL_FPoint &a = points[j], &b = points[i];
+          // Half open in y, so a vertex shared by two edges is only counted once
+          if ((a.y <= center) == (b.y <= center)) continue;
+          crossings[crossing_count++] = a.x + (center - a.y) * (b.x - a.x) / (b.y - a.y);
+        }
+      std::sort(crossings, crossings + crossing_count);
+
+      for (size_t i = 0; i + 1 < crossing_count; i += 2)
+        {
+          // Tiles whose center x + 0.5 is in [left, right)
+          const int x0 = static_cast<int>(SDL_ceilf(crossings[i] - 0.5f));
+          const int x1 = static_cast<int>(SDL_ceilf(crossings[i + 1] - 0.5f));
+          set_span(y, x0, x1);
+        }
+    }
+}
+
+void TileBits::fill_disc(SDL_Point center, int radius)
+{
+  for (int dy = -radius; dy <= radius; ++dy)
+    {
+      // Widest offset in the row, the `+ radius` rounds small discs out of
+      // diamonds into circles
+      int half = 0;
+      while ((half + 1) * (half + 1) + dy * dy <= radius * radius + radius) ++half;
+      set_span(center.y + dy, center.x - half, center.x + half + 1);
+    }
+}
+
+// Bresenham, a disc on every tile of the line
+void TileBits::fill_line(SDL_Point a, SDL_Point b, int radius)
+{
+  const int dx = std::abs(b.x - a.x), dy = -std::abs(b.y - a.y);
+  const int sx = a.x < b.x ? 1 : -1, sy = a.y < b.y ? 1 : -1;
+  int error = dx + dy;
+  for (;;)
+    {
+      fill_disc(a, radius);
+      if (a.x == b.x && a.y == b.y) break;
+
+      const int e2 = 2 * error;
+      if (e2 >= dy)
+        {
+          error += dy;
+          a.x += sx;
+        }
+      if (e2 <= dx)
+        {
+          error += dx;
+          a.y += sy;
+        }
+    }
+}
+
+void apply_selection(TileBits &selection, const TileBits &shape, SelectOp op)
+{
+  switch (op)
+    {
+    case SelectOp::Replace:   selection.words = shape.words; break;
+    case SelectOp::Union:     selection.unite(shape); break;
+    case SelectOp::Intersect: selection.intersect(shape); break;
+    case SelectOp::Subtract:  selection.subtract(shape); break;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "config.h"
+#include "memory.h"
+
+static_assert(MAP_SIZE % 64 == 0, "selection rows must start on a word boundary");
+
+// One bit per tile, row major like the other map planes. Every row is a whole
+// number of 64-bit words, so set operations run a word at a time and spans
+// and runs can be found with bit scans instead of per tile tests.
+class TileBits
+{
+public:
+  static constexpr int ROW_WORDS = MAP_SIZE / 64;
+  static constexpr int WORDS = ROW_WORDS * MAP_SIZE;
+
+  bool test(int index) const { return (words[index >> 6] >> (index & 63)) & 1; }
+  void flip(int index) { words[index >> 6] ^= uint64_t{1} << (index & 63); }
+  void clear() { std::fill(words.begin(), words.end(), 0); }
+  int count() const;
+
+  void unite(const TileBits &other);
+  void intersect(const TileBits &other);
+  void subtract(const TileBits &other);
+  void invert();
+
+  // Tiles [x0, x1) of row `y`, clamped to the map
+  void set_span(int y, int x0, int x1);
+  // `area` in tile coordinates, clamped to the map
+  void fill_rect(const SDL_Rect &area);
+  // Tiles whose center is inside the polygon (even-odd rule), `points` in tile
+  // units. Rasterised one scanline per tile row, with its crossings in `scratch`.
+  void fill_polygon(const std::vector<SDL_FPoint> &points, Arena &scratch);
+  // Tiles within `radius` of `center`, the tile alone for 0
+  void fill_disc(SDL_Point center, int radius);
+  // Discs along the line from `a` to `b`, both ends included
+  void fill_line(SDL_Point a, SDL_Point b, int radius);
+
+  // Calls `emit(x0, x1)` for every run of set tiles of row `y` within [x0, x1)
+  template <typename Emit>
+  void for_each_run(int y, int x0, int x1, Emit &&emit) const
+  {
+    int x = x0;
+    while (x < x1)
+      {
+        const int start = next_bit(y, x, x1, true);
+        if (start >= x1) break;
+        const int end = next_bit(y, start, x1, false);
+        emit(start, end);
+        x = end;
+      }
+  }
+
+  std::vector<uint64_t> words = std::vector<uint64_t>(WORDS, 0);
+
+private:
+  // First x in [x, end) of row `y` whose bit is `value`, `end` if none
+  int next_bit(int y, int x, int end, bool value) const
+  {
+    const uint64_t *row = &words[y * ROW_WORDS];
+    while (x < end)
+      {
+        const uint64_t word = (value ? row[x >> 6] : ~row[x >> 6]) >> (x & 63);
+        if (word) return std::min(end, x + std::countr_zero(word));
+        x = (x | 63) + 1;
+      }
+    return end;
+  }
+};
+
+enum class SelectOp
+{
+  Replace,
+  Union,
+  Intersect,
+  Subtract,
+};
+
+// Combine `shape` into `selection`
+void apply_selection(TileBits &selection, const TileBits &shape, SelectOp op);
@@ -0,0 +1,260 @@
+#include "sim.h"
+
+static uint8_t initial_state(TerrainKind kind)
+{
+  return kind == TerrainKind::Water ? WATER_DEPTH : 0;
+}
+
+static uint8_t mask(bool condition)
+{
+  return static_cast<uint8_t>(-static_cast<int>(condition));
+}
+
+void TerrainSim::reset()
+{
+  // Whatever is in the map is kept, in both buffers
+  back_kinds = tiles.kinds;
+  for (int index = 0; index < TILE_COUNT; ++index)
+    {
+      state[index] = back_state[index] = initial_state(tiles.kinds[index]);
+    }
+  std::fill(live.begin(), live.end(), 0);
+  std::fill(active.begin(), active.end(), 0);
+  changed.clear();
+}
+
+bool TerrainSim::is_live(int x, int y) const
+{
+  return x >= 0 && y >= 0 && x < MAP_SIZE && y < MAP_SIZE && live[(y / CHUNK_SIZE) * CHUNK_COUNT + x / CHUNK_SIZE];
+}
+
+// The chunk and its neighbors, whose halo it is part of
+void TerrainSim::wake(int chunk_index)
+{
+  const int cx = chunk_index % CHUNK_COUNT;
+  const int cy = chunk_index / CHUNK_COUNT;
+  for (int y = std::max(0, cy - 1); y <= std::min(CHUNK_COUNT - 1, cy + 1); ++y)
+    {
+      for (int x = std::max(0, cx - 1); x <= std::min(CHUNK_COUNT - 1, cx + 1); ++x)
+        {
+          if (live[y * CHUNK_COUNT + x]) active[y * CHUNK_COUNT + x] = 1;
+        }
+    }
+}
+
+void TerrainSim::add_chunk(int chunk_index)
+{
+  const int x0 = (chunk_index % CHUNK_COUNT) * CHUNK_SIZE;
+  const int y0 = (chunk_index / CHUNK_COUNT) * CHUNK_SIZE;
+  for (int y = y0; y < y0 + CHUNK_SIZE; ++y)
+    {
+      for (int x = x0; x < x0 + CHUNK_SIZE; ++x)
+        {
+          const int index = y * MAP_SIZE + x;
+          back_kinds[index] = tiles.kinds[index];
+          state[index] = back_state[index] = initial_state(tiles.kinds[index]);
+        }
+    }
+
+  live[chunk_index] = 1;
+  wake(chunk_index);
+}
+
+void TerrainSim::reset_tile(int index)
+{
+  back_kinds[index] = tiles.kinds[index];
+  state[index] = back_state[index] = initial_state(tiles.kinds[index]);
+}
+
+void TerrainSim::wake_area(const SDL_Rect &area)
+{
+  const int x0 = std::max(0, area.x / CHUNK_SIZE - 1);
+  const int y0 = std::max(0, area.y / CHUNK_SIZE - 1);
+  const int x1 = std::min(CHUNK_COUNT - 1, (area.x + area.w - 1) / CHUNK_SIZE + 1);
+  const int y1 = std::min(CHUNK_COUNT - 1, (area.y + area.h - 1) / CHUNK_SIZE + 1);
+  for (int y = y0; y <= y1; ++y)
+    {
+      for (int x = x0; x <= x1; ++x)
+        {
+          if (live[y * CHUNK_COUNT + x]) active[y * CHUNK_COUNT + x] = 1;
+        }
+    }
+}
+
+void TerrainSim::set(int index)
+{
+  reset_tile(index);
+
+  const int chunk_index = (index / MAP_SIZE / CHUNK_SIZE) * CHUNK_COUNT + (index % MAP_SIZE) / CHUNK_SIZE;
+  if (live[chunk_index]) wake(chunk_index);
+}
+
+void TerrainSim::activate_all()
+{
+  std::copy(live.begin(), live.end(), active.begin());
+}
+
+const std::vector<int> &TerrainSim::step(JobSystem &jobs)
+{
+  changed.clear();
+
+  stepping.clear();
+  for (int index = 0; index < CHUNK_COUNT * CHUNK_COUNT; ++index)
+    {
+      if (active[index])
+        {
+          stepping.push_back(index);
+          active[index] = 0;
+        }
+    }
+  stepped = static_cast<int>(stepping.size());
+  if (stepping.empty()) return changed;
+
+  // The active chunks are row major, so even slices of them are bands of chunk
+  // rows. Halos are read straight from the front planes, which nothing writes
+  // during the step.
+  const int band_count = std::clamp(stepped / SIM_BAND_CHUNKS, 1, std::max(1, jobs.worker_count()));
+  bands.resize(band_count);
+  for (int b = 0; b < band_count; ++b)
+    {
+      Band &band = bands[b];
+      band.first = stepped * b / band_count;
+      band.last = stepped * (b + 1) / band_count;
+      band.changed.clear();
+      band.changed_chunks.clear();
+    }
+
+  auto run_band = [this](Band &band)
+    {
+      for (int i = band.first; i < band.last; ++i) step_chunk(stepping[i], band);
+    };
+
+  if (band_count == 1)
+    {
+      run_band(bands[0]);
+    }
+  else
+    {
+      // Chunk generation and texture loads may be queued too, only the bands are waited for
+      JobGroup group;
+      for (Band &band : bands)
+        {
+          jobs.submit([&run_band, &band] { run_band(band); }, &group);
+        }
+      jobs.wait(group);
+    }
+
+  std::swap(tiles.kinds, back_kinds);
+  std::swap(state, back_state);
+
+  for (Band &band : bands)
+    {
+      changed.insert(changed.end(), band.changed.begin(), band.changed.end());
+      for (int chunk_index : band.changed_chunks) wake(chunk_index);
+    }
+  return changed;
+}
+
+void TerrainSim::step_chunk(int chunk_index, Band &band)
+{
+  constexpr int P = CHUNK_SIZE + 2; // padded with the halo
+  const int x0 = (chunk_index % CHUNK_COUNT) * CHUNK_SIZE;
+  const int y0 = (chunk_index / CHUNK_COUNT) * CHUNK_SIZE;
+
+
+  // Gather the chunk and a one tile halo from the front planes, by rows of the
+  // 3x3 chunks around it
+  const int cx = chunk_index % CHUNK_COUNT;
+  const int cy = chunk_index / CHUNK_COUNT;
+  bool around[3][3];
+  for (int dy = 0; dy < 3; ++dy)
+    {
+      for (int dx = 0; dx < 3; ++dx)
+        {
+          around[dy][dx] = is_live((cx + dx - 1) * CHUNK_SIZE, (cy + dy - 1) * CHUNK_SIZE);
+        }
+    }
+
+  uint8_t kind[P * P], value[P * P];
+  for (int py = 0; py < P; ++py)
+    {
+      const int y = y0 + py - 1;
+      const bool *live_row = around[py == 0 ? 0 : py == P - 1 ? 2 : 1];
+      const int spans[3][3] = {{0, x0 - 1, 1}, {1, x0, CHUNK_SIZE}, {P - 1, x0 + CHUNK_SIZE, 1}}; // padded x, map x, width
+      for (int i = 0; i < 3; ++i)
+        {
+          uint8_t *k = &kind[py * P + spans[i][0]];
+          uint8_t *v = &value[py * P + spans[i][0]];
+          if (live_row[i])
+            {
+              std::copy_n(reinterpret_cast<const uint8_t *>(&tiles.kinds[y * MAP_SIZE + spans[i][1]]), spans[i][2], k);
+              std::copy_n(&state[y * MAP_SIZE + spans[i][1]], spans[i][2], v);
+            }
+          else
+            {
+              std::fill_n(k, spans[i][2], TerrainKind::Mountain);
+              std::fill_n(v, spans[i][2], 0);
+            }
+        }
+    }
+
+  bool any_change = false;
+  for (int y = 0; y < CHUNK_SIZE; ++y)
+    {
+      const uint8_t *up = &kind[y * P], *mid = &kind[(y + 1) * P], *down = &kind[(y + 2) * P];
+      const uint8_t *v_up = &value[y * P], *v_mid = &value[(y + 1) * P], *v_down = &value[(y + 2) * P];
+      uint8_t next_kind[CHUNK_SIZE], next_value[CHUNK_SIZE];
+
+      // Every rule is evaluated for every tile and the tile's kind selects the
+      // result through masks (0 or 0xff). The loop has no branches and
+      // vectorizes over the row.
+      for (int x = 0; x < CHUNK_SIZE; ++x)
+        {
+          const int c = x + 1;
+          const uint8_t k = mid[c];
+          const uint8_t s = v_mid[c];
+
+          const uint8_t deepest = std::max(std::max(uint8_t(mask(up[c] == Water) & v_up[c]), uint8_t(mask(down[c] == Water) & v_down[c])),
+                                           std::max(uint8_t(mask(mid[c - 1] == Water) & v_mid[c - 1]), uint8_t(mask(mid[c + 1] == Water) & v_mid[c + 1])));
+          const uint8_t shallower = deepest - (deepest != 0);
+          const uint8_t grass = (up[c - 1] == Grass) + (up[c] == Grass) + (up[c + 1] == Grass) + (mid[c - 1] == Grass) +
+                                (mid[c + 1] == Grass) + (down[c - 1] == Grass) + (down[c] == Grass) + (down[c + 1] == Grass);
+          const uint8_t water = (up[c - 1] == Water) + (up[c] == Water) + (up[c + 1] == Water) + (mid[c - 1] == Water) +
+                                (mid[c + 1] == Water) + (down[c - 1] == Water) + (down[c] == Water) + (down[c + 1] == Water);
+
+          const uint8_t is_water = mask(k == Water), is_dirt = mask(k == Dirt), is_sand = mask(k == Sand);
+          const uint8_t sum = s + grass;
+          const uint8_t growth = sum | mask(sum < s); // saturated
+          const uint8_t erosion = mask(water >= SAND_EXPOSURE) & uint8_t(s + 1);
+
+          const uint8_t flood = mask(k == Crust) & mask(deepest > 1);
+          const uint8_t grow = is_dirt & mask(growth >= GRASS_GROWTH);
+          const uint8_t erode = is_sand & mask(erosion >= SAND_EROSION);
+          const uint8_t keep = ~(flood | grow | erode);
+
+          next_kind[x] = ((flood | erode) & Water) | (grow & Grass) | (keep & k);
+          next_value[x] = (flood & shallower) | (erode & 1) | (is_water & std::max(s, shallower)) |
+                          (is_dirt & ~grow & growth) | (is_sand & ~erode & erosion);
+        }
+
+      uint8_t diff = 0;
+      for (int x = 0; x < CHUNK_SIZE; ++x)
+        {
+          diff |= (next_kind[x] ^ mid[x + 1]) | (next_value[x] ^ v_mid[x + 1]);
+        }
+
+      const int row = (y0 + y) * MAP_SIZE + x0;
+      if (diff)
+        {
+          any_change = true;
+          for (int x = 0; x < CHUNK_SIZE; ++x)
+            {
+              if (next_kind[x] != mid[x + 1]) band.changed.push_back(row + x);
+            }
+        }
+      std::copy_n(next_kind, CHUNK_SIZE, reinterpret_cast<uint8_t *>(&back_kinds[row]));
+      std::copy_n(next_value, CHUNK_SIZE, &back_state[row]);
+    }
+
+  if (any_change) band.changed_chunks.push_back(chunk_index);
+}
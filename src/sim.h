@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "config.h"
+#include "tile.h"
+#include "jobs.h"
+
+// Terrain processes, one step every TERRAIN_SIM_INTERVAL updates:
+//  - Water flows over Crust, one shallower than the deepest water next to it,
+//    until its depth runs out
+//  - Dirt regrows into Grass, faster the more Grass is around it
+//  - Sand with SAND_EXPOSURE or more Water tiles around it erodes into Water
+inline constexpr uint8_t WATER_DEPTH = 4;     // of generated water
+inline constexpr int GRASS_GROWTH = 240;      // Grass neighbors summed over the steps
+inline constexpr int SAND_EXPOSURE = 5;       // of the 8 neighbors
+inline constexpr int SAND_EROSION = 100;      // steps exposed
+inline constexpr int SIM_BAND_CHUNKS = 16;    // fewer active chunks per worker are stepped inline
+
+// Cellular automaton over the map. The kinds and a per-tile state (water
+// depth, growth or erosion, depending on the kind) are double buffered: a step
+// reads the front planes and writes the back ones, so the tiles are updated in
+// any order and on any thread, then the planes are swapped. The front kind
+// plane is `tiles.kinds` itself.
+//
+// Only active chunks are stepped. A chunk stays active while anything in it
+// changes and wakes its neighbors when it does. A chunk that went a whole step
+// without changing holds the same tiles in both buffers, so skipping it is
+// exact. That holds for the rest of the map as long as everything else writing
+// `tiles.kinds` tells the simulation with `reset`, `add_chunk` or `set`.
+//
+// Chunks join once they are generated or loaded, the others read as Mountain,
+// which nothing reacts to.
+//
+// @note: the state isn't saved, water loaded from a save gets WATER_DEPTH back
+class TerrainSim
+{
+public:
+  explicit TerrainSim(TileMap &tiles) : tiles(tiles) {}
+
+  // Drop every chunk, e.g. for a new map. Takes the map as it is.
+  void reset();
+  // The kinds of a chunk are in the map, it joins the simulation
+  void add_chunk(int chunk_index);
+  // `tiles.kinds[index]` was changed by something else than the simulation
+  void set(int index);
+  // Same for many tiles at once: `reset_tile` each of them, then wake the
+  // chunks around their area once
+  void reset_tile(int index);
+  void wake_area(const SDL_Rect &area);
+  // Step every chunk next time, not only the changing ones
+  void activate_all();
+
+  // Step the active chunks, bands of chunk rows go to the workers. Returns the
+  // tiles whose kind changed, `previous` has their old kind until the next step.
+  const std::vector<int> &step(JobSystem &jobs);
+  TerrainKind previous(int index) const { return back_kinds[index]; }
+
+  int active_count() const { return static_cast<int>(std::count(active.begin(), active.end(), 1)); }
+  int stepped_count() const { return stepped; } // chunks in the last step
+
+private:
+  struct Band
+  {
+    int first, last; // range of `stepping`
+    std::vector<int> changed; // tiles whose kind changed
+    std::vector<int> changed_chunks; // anything changed, state included
+  };
+
+  void step_chunk(int chunk_index, Band &band);
+  void wake(int chunk_index);
+  bool is_live(int x, int y) const;
+
+  TileMap &tiles;
+  std::vector<TerrainKind> back_kinds = std::vector<TerrainKind>(TILE_COUNT, TerrainKind::Crust);
+  std::vector<uint8_t> state = std::vector<uint8_t>(TILE_COUNT, 0);
+  std::vector<uint8_t> back_state = std::vector<uint8_t>(TILE_COUNT, 0);
+
+  std::vector<uint8_t> live = std::vector<uint8_t>(CHUNK_COUNT * CHUNK_COUNT, 0);
+  std::vector<uint8_t> active = std::vector<uint8_t>(CHUNK_COUNT * CHUNK_COUNT, 0);
+  std::vector<int> stepping; // active chunks of the current step, row major
+  std::vector<Band> bands;
+  std::vector<int> changed;
+  int stepped = 0;
+};
@@ -0,0 +1,51 @@
+#include "text.h"
+
+bool TextEngine::create(SDL_Renderer *renderer, TTF_Font *base_font)
+{
+  engine = TTF_CreateRendererTextEngine(renderer);
+  if (!engine)
+    {
+      SDL_Log("Couldn't create text engine: %s\n", SDL_GetError());
+      return false;
+    }
+  base = base_font;
+  return true;
+}
+
+void TextEngine::destroy()
+{
+  for (auto &entry : fonts)
+    {
+      if (entry.font) TTF_CloseFont(entry.font);
+      entry = {};
+    }
+  if (engine) TTF_DestroyRendererTextEngine(engine);
+  engine = nullptr;
+}
+
+TTF_Font *TextEngine::font(float size)
+{
+  for (auto &entry : fonts)
+    {
+      if (entry.font && entry.size == size) return entry.font;
+    }
+
+  for (auto &entry : fonts)
+    {
+      if (entry.font) continue;
+
+      entry.font = TTF_CopyFont(base);
+      if (!entry.font || !TTF_SetFontSize(entry.font, size))
+        {
+          SDL_Log("Couldn't create font of size %f: %s\n", size, SDL_GetError());
+          if (entry.font) TTF_CloseFont(entry.font);
+          entry = {};
+          return nullptr;
+        }
+      entry.size = size;
+      return entry.font;
+    }
+
+  SDL_Log("Too many font sizes in use, can't create size %f\n", size);
+  return nullptr;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+// Owns SDL_ttf's renderer text engine, which caches rasterized glyphs in atlas
+// textures and draws `TTF_Text` objects through batched geometry. Since the
+// atlas is keyed by font, every size in use gets its own copy of the font.
+class TextEngine
+{
+public:
+  bool create(SDL_Renderer *renderer, TTF_Font *base_font);
+  void destroy();
+
+  // Font at `size` points, created on first use
+  TTF_Font *font(float size);
+
+  TTF_TextEngine *engine = nullptr;
+
+private:
+  static constexpr int MAX_SIZES = 8;
+
+  struct SizedFont
+  {
+    float size = 0;
+    TTF_Font *font = nullptr;
+  };
+
+  TTF_Font *base = nullptr;
+  std::array<SizedFont, MAX_SIZES> fonts;
+};
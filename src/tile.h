@@ -1,11 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <vector>
+#include <cstdint>
 
 #include <SDL3/SDL.h>
 
 #include "config.h"
-#include "asset.h"
+#include "batch.h"
+#include "selection.h"
 
 enum TerrainKind : uint8_t
 {
@@ -13,23 +17,53 @@ enum TerrainKind : uint8_t
   Water,
   Dirt,
   Grass,
+  Sand,
+  Snow,
+  Forest,
+  Mountain,
+  Swamp,
+  Lava,
   TERRAIN_KIND_COUNT,
 };
 
+inline constexpr int TILE_COUNT = MAP_SIZE * MAP_SIZE;
+
+// The map is stored as parallel planes indexed by `y * MAP_SIZE + x`. Anything
+// that can be derived from the index (coord, rect) is computed on demand.
+struct TileMap
+{
+  std::vector<TerrainKind> kinds = std::vector<TerrainKind>(TILE_COUNT, TerrainKind::Crust);
+  TileBits selection;
+  std::vector<uint8_t> sprites = std::vector<uint8_t>(TILE_COUNT, 0); // index in the autotile sheet
+
+  static constexpr size_t size() { return TILE_COUNT; }
+
+  bool is_selected(int index) const { return selection.test(index); }
+  void toggle_selected(int index) { selection.flip(index); }
+  void clear_selection() { selection.clear(); }
+};
+
+// Lightweight handle to a tile in a `TileMap`
 struct Tile
 {
-  using Tiles = const std::array<Tile, MAP_SIZE * MAP_SIZE>&;
-
-  TerrainKind kind;
-  
-  SDL_FRect rect;
-  SDL_FRect sprite;
-  SDL_Point coord; 
-  bool selected;
-
-  std::array<int, 8> get_neighbors(int map_size) const;
-  SDL_FRect get_bitmask(Tiles tiles) const;
-  void render(SDL_Renderer *renderer, Tiles tiles, bool mouse_hover, const Asset& assets) const;
+  int index;
+
+  SDL_Point coord() const { return {index % MAP_SIZE, index / MAP_SIZE}; }
+  SDL_FRect rect() const
+  {
+    return {static_cast<float>(index % MAP_SIZE) * TILE_SIZE,
+            static_cast<float>(index / MAP_SIZE) * TILE_SIZE,
+            static_cast<float>(TILE_SIZE),
+            static_cast<float>(TILE_SIZE)};
+  }
+
+  // Neighbor indices clockwise starting at the top, -1 outside of the map
+  std::array<int, 8> get_neighbors() const;
+  // Autotile sprite index for this tile given its neighbors
+  uint8_t get_bitmask(const TileMap &tiles) const;
+  // `origin` is the world position of the render target (e.g. the chunk) we
+  // draw into, `atlas` is the autotile sheet, tiles are drawn flat without it
+  void render(TileBatch &batch, const TileMap &tiles, SDL_FPoint origin, SDL_Texture *atlas) const;
 };
 
 const SDL_Color TERRAIN_COLORS[TERRAIN_KIND_COUNT] = {
@@ -37,13 +71,17 @@ const SDL_Color TERRAIN_COLORS[TERRAIN_KIND_COUNT] = {
     {30, 90, 150, SDL_ALPHA_OPAQUE},   // Water
     {139, 69, 19, SDL_ALPHA_OPAQUE},   // Dirt
     {34, 139, 34, SDL_ALPHA_OPAQUE},   // Grass 
-    /* {240, 220, 130, SDL_ALPHA_OPAQUE}, // Sand */
-    /* {220, 230, 240, SDL_ALPHA_OPAQUE}, // Snow */
-    /* {34, 94, 34, SDL_ALPHA_OPAQUE},    // Forest */
-    /* {100, 110, 110, SDL_ALPHA_OPAQUE}, // Mountain */
-    /* {80, 90, 60, SDL_ALPHA_OPAQUE},    // Swamp */
-    /* {255, 69, 0, SDL_ALPHA_OPAQUE}     // Lava */
+    {240, 220, 130, SDL_ALPHA_OPAQUE}, // Sand
+    {220, 230, 240, SDL_ALPHA_OPAQUE}, // Snow
+    {34, 94, 34, SDL_ALPHA_OPAQUE},    // Forest
+    {100, 110, 110, SDL_ALPHA_OPAQUE}, // Mountain
+    {80, 90, 60, SDL_ALPHA_OPAQUE},    // Swamp
+    {255, 69, 0, SDL_ALPHA_OPAQUE}     // Lava
     // Make sure the order here matches the enum order exactly!
 };
 
+// Names used in data files, same order as the enum
+const char *const TERRAIN_NAMES[TERRAIN_KIND_COUNT] = {"Crust", "Water", "Dirt", "Grass", "Sand",
+                                                       "Snow", "Forest", "Mountain", "Swamp", "Lava"};
+
 #define SDL_COLOR_RGBA(color) (color).r, (color).g, (color).b, (color).a
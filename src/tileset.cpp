@@ -1,67 +1,68 @@
 #include "tileset.h"
 
-SDL_Point get_terrain_mask(int mask)
+// Tiles [x0, x1) of row `y`, neither on the map border:
+// the 8 comparisons are branch free over three rows so the compiler can
+// vectorize them, the table lookup happens in a second pass.
+static void autotile_span(TileMap &tiles, int y, int x0, int x1)
 {
-  switch (mask)
+  const TerrainKind *up = &tiles.kinds[(y - 1) * MAP_SIZE];
+  const TerrainKind *row = &tiles.kinds[y * MAP_SIZE];
+  const TerrainKind *down = &tiles.kinds[(y + 1) * MAP_SIZE];
+
+  std::array<uint8_t, MAP_SIZE> masks;
+  for (int x = x0; x < x1; ++x)
+    {
+      const TerrainKind k = row[x];
+      masks[x] = static_cast<uint8_t>(
+        (up[x] == k)           |
+        ((up[x + 1] == k) << 1)   |
+        ((row[x + 1] == k) << 2)  |
+        ((down[x + 1] == k) << 3) |
+        ((down[x] == k) << 4)     |
+        ((down[x - 1] == k) << 5) |
+        ((row[x - 1] == k) << 6)  |
+        ((up[x - 1] == k) << 7));
+    }
+
+  uint8_t *sprites = &tiles.sprites[y * MAP_SIZE];
+  for (int x = x0; x < x1; ++x)
     {
-    case 0:   return {0, 0};
-    case 4:   return {1, 0};
-    case 84:  return {2, 0};
-    case 92:  return {3, 0};
-    case 124: return {4, 0};
-    case 116: return {5, 0};
-    case 80:  return {6, 0};
-    case 16:  return {0, 1};
-    case 28:  return {1, 1};
-    case 117: return {2, 1};
-    case 95:  return {3, 1};
-    case 255: return {4, 2};
-      // {
-      //   static const std::array<SDL_Point, 3> options = {{{4, 2},
-      //                                                     {1, 4},
-      //                                                     {4, 1}}};
+      sprites[x] = AUTOTILE_TABLE[masks[x]];
+    }
+}
+
+void autotile_map(TileMap &tiles)
+{
+  autotile_rect(tiles, {0, 0, MAP_SIZE, MAP_SIZE});
+}
+
+void autotile_rect(TileMap &tiles, SDL_Rect area)
+{
+  const int x0 = std::max(0, area.x);
+  const int y0 = std::max(0, area.y);
+  const int x1 = std::min(MAP_SIZE, area.x + area.w);
+  const int y1 = std::min(MAP_SIZE, area.y + area.h);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  // Tiles on the map border need bounds checks, they go through the per tile path
+  auto one = [&](int x, int y) { tiles.sprites[y * MAP_SIZE + x] = Tile{y * MAP_SIZE + x}.get_bitmask(tiles); };
+  const int inner_x0 = std::max(1, x0), inner_x1 = std::min(MAP_SIZE - 1, x1);
 
-      //   static std::random_device rd;
-      //   static std::mt19937 rng(rd());
-      //   static std::uniform_int_distribution<std::size_t> dist(0, options.size() - 1);
+  for (int y = y0; y < y1; ++y)
+    {
+      if (y == 0 || y == MAP_SIZE - 1 || inner_x0 >= inner_x1)
+        {
+          for (int x = x0; x < x1; ++x) one(x, y);
+          continue;
+        }
 
-      //   return options[dist(rng)];
-      // }
-    case 253: return {5, 1};
-    case 113: return {6, 1};
-    case 21:  return {0, 2};
-    case 87:  return {1, 2};
-    case 221: return {2, 2};
-    case 127: return {3, 2};
-    case 247: return {5, 2};
-    case 209: return {6, 2};
-    case 29:  return {0, 3};
-    case 125: return {1, 3};
-    case 119: return {2, 3};
-    case 199: return {3, 3};
-    case 215: return {4, 3};
-    case 213: return {5, 3};
-    case 81:  return {6, 3};
-    case 31:  return {0, 4};
-    case 241: return {2, 4};
-    case 20:  return {3, 4};
-    case 65:  return {4, 4};
-    case 17:  return {5, 4};
-    case 1:   return {6, 4};
-    case 23:  return {0, 5};
-    case 223: return {1, 5};
-    case 245: return {2, 5};
-    case 85:  return {3, 5};
-    case 68:  return {4, 5};
-    case 93:  return {5, 5};
-    case 112: return {6, 5};
-    case 5:   return {0, 6};
-    case 71:  return {1, 6};
-    case 197: return {2, 6};
-    case 69:  return {3, 6};
-    case 64:  return {4, 6};
-    case 7:   return {5, 6};
-    case 193: return {6, 6};
-    default:  return {0, 0};
+      if (x0 == 0) one(0, y);
+      autotile_span(tiles, y, inner_x0, inner_x1);
+      if (x1 == MAP_SIZE) one(MAP_SIZE - 1, y);
     }
 }
+
+void autotile_around(TileMap &tiles, int index)
+{
+  autotile_rect(tiles, {index % MAP_SIZE - 1, index / MAP_SIZE - 1, 3, 3});
+}